@@ -25,6 +25,7 @@ public class HTTPLink : ModuleRules
 			new string[]
 			{
 				"Core",
+				"Json",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -37,14 +38,17 @@ public class HTTPLink : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
+				"HTTP",
 				"HTTPServer",
 				"ApplicationCore",
 				"AssetRegistry",
+				"AssetTools",
+				"ImageWrapper",
 				"UnrealEd",
 				"LevelEditor",
 				"DesktopPlatform",
-				"Json",
 				"JsonUtilities",
+				"SourceControl",
 			}
 			);
 		
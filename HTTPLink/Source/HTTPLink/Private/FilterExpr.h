@@ -0,0 +1,536 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
+
+
+// Small filter language for actor / asset queries.
+//   class==StaticMeshActor && label~"Rock*" && location.z>100
+//   !hidden && (name!=Floor || tags~"*Ground*")
+// Grammar:
+//   Or      := And ('||' And)*
+//   And     := Unary ('&&' Unary)*
+//   Unary   := '!' Unary | '(' Or ')' | Compare
+//   Compare := Field [Op Literal]      (without Op, tests the truthiness of the field)
+//   Op      := '==' | '!=' | '<' | '<=' | '>' | '>=' | '~' | '!~'   ('~' is wildcard match with * and ?)
+//   Literal := number | "quoted string" | bare word | true | false
+// String comparisons are case-insensitive. If the literal is a number, string fields are compared numerically.
+// Field names are resolved to accessors at compile time, so evaluation doesn't do any name lookup.
+// A compiled expression is immutable and can be evaluated from multiple threads at once.
+
+struct FFilterValue
+{
+    enum class EType : uint8
+    {
+        None,
+        Bool,
+        Number,
+        String,
+    };
+
+    EType Type = EType::None;
+    bool Bool = false;
+    double Number = 0.0;
+    FString String;
+
+    void Reset() { Type = EType::None; }
+    void SetBool(bool V) { Type = EType::Bool; Bool = V; }
+    void SetNumber(double V) { Type = EType::Number; Number = V; }
+    void SetString(const FString& V) { Type = EType::String; String = V; }
+    void SetString(FString&& V) { Type = EType::String; String = MoveTemp(V); }
+};
+
+template<class T>
+class TFilterExpr
+{
+public:
+    // writes the value of a field of Obj to Dst
+    using FAccessor = TFunction<void(const T& Obj, FFilterValue& Dst)>;
+    // returns an empty function if Name is not a known field
+    using FResolver = TFunction<FAccessor(const FString& Name)>;
+
+    static TSharedPtr<TFilterExpr> Compile(const FString& Source, const FResolver& Resolver, FString* OutError = nullptr)
+    {
+        TSharedPtr<TFilterExpr> Ret = MakeShareable(new TFilterExpr());
+        FParser Parser(*Ret, Source, Resolver);
+        if (!Parser.Parse()) {
+            if (OutError) {
+                *OutError = Parser.Error;
+            }
+            return nullptr;
+        }
+        return Ret;
+    }
+
+    bool Evaluate(const T& Obj) const
+    {
+        FFilterValue Tmp;
+        return Evaluate(Obj, Tmp);
+    }
+
+    // Tmp is a scratch buffer to avoid allocations across calls
+    bool Evaluate(const T& Obj, FFilterValue& Tmp) const
+    {
+        return EvaluateNode(Root, Obj, Tmp);
+    }
+
+    // evaluates Objects in parallel chunks. Matches[I] is set to 1 if Objects[I] passes the filter.
+    void EvaluateParallel(TArrayView<const T> Objects, TArray<uint8>& Matches, int32 ChunkSize = 256) const
+    {
+        Matches.SetNumZeroed(Objects.Num());
+        const int32 NumChunks = FMath::DivideAndRoundUp(Objects.Num(), ChunkSize);
+        ParallelFor(NumChunks, [&](int32 Chunk) {
+            FFilterValue Tmp;
+            const int32 Begin = Chunk * ChunkSize;
+            const int32 End = FMath::Min(Begin + ChunkSize, Objects.Num());
+            for (int32 I = Begin; I < End; ++I) {
+                Matches[I] = Evaluate(Objects[I], Tmp) ? 1 : 0;
+            }
+            });
+    }
+
+    int32 NumNodes() const { return Nodes.Num(); }
+
+private:
+    enum class EOp : uint8
+    {
+        And,
+        Or,
+        Not,
+        Test,
+        Eq,
+        Ne,
+        Lt,
+        Le,
+        Gt,
+        Ge,
+        Match,
+        NotMatch,
+    };
+
+    struct FNode
+    {
+        EOp Op = EOp::Test;
+        // operands of And / Or / Not
+        int32 Lhs = INDEX_NONE;
+        int32 Rhs = INDEX_NONE;
+        // field and literal of comparisons
+        int32 Field = INDEX_NONE;
+        FFilterValue Literal;
+    };
+
+    TArray<FNode> Nodes;
+    TArray<FAccessor> Accessors;
+    int32 Root = INDEX_NONE;
+
+    TFilterExpr() {}
+
+    bool EvaluateNode(int32 Index, const T& Obj, FFilterValue& Tmp) const
+    {
+        const FNode& Node = Nodes[Index];
+        switch (Node.Op) {
+        case EOp::And: return EvaluateNode(Node.Lhs, Obj, Tmp) && EvaluateNode(Node.Rhs, Obj, Tmp);
+        case EOp::Or: return EvaluateNode(Node.Lhs, Obj, Tmp) || EvaluateNode(Node.Rhs, Obj, Tmp);
+        case EOp::Not: return !EvaluateNode(Node.Lhs, Obj, Tmp);
+        default: break;
+        }
+
+        Tmp.Reset();
+        Accessors[Node.Field](Obj, Tmp);
+        return Compare(Node, Tmp);
+    }
+
+    static bool Compare(const FNode& Node, const FFilterValue& V)
+    {
+        switch (Node.Op) {
+        case EOp::Test:
+            switch (V.Type) {
+            case FFilterValue::EType::Bool: return V.Bool;
+            case FFilterValue::EType::Number: return V.Number != 0.0;
+            case FFilterValue::EType::String: return !V.String.IsEmpty();
+            default: return false;
+            }
+        case EOp::Match:
+        case EOp::NotMatch:
+        {
+            bool Matched = false;
+            if (V.Type == FFilterValue::EType::String) {
+                Matched = V.String.MatchesWildcard(Node.Literal.String);
+            }
+            else if (V.Type == FFilterValue::EType::Number) {
+                Matched = FString::SanitizeFloat(V.Number, 0).MatchesWildcard(Node.Literal.String);
+            }
+            return Node.Op == EOp::Match ? Matched : !Matched;
+        }
+        default:
+            break;
+        }
+
+        int32 Order;
+        if (!GetOrder(V, Node.Literal, Order)) {
+            // incomparable values are only "not equal"
+            return Node.Op == EOp::Ne;
+        }
+        switch (Node.Op) {
+        case EOp::Eq: return Order == 0;
+        case EOp::Ne: return Order != 0;
+        case EOp::Lt: return Order < 0;
+        case EOp::Le: return Order <= 0;
+        case EOp::Gt: return Order > 0;
+        case EOp::Ge: return Order >= 0;
+        default: return false;
+        }
+    }
+
+    static bool GetOrder(const FFilterValue& A, const FFilterValue& B, int32& Order)
+    {
+        auto Sign = [](double D) { return D < 0.0 ? -1 : (D > 0.0 ? 1 : 0); };
+        switch (B.Type) {
+        case FFilterValue::EType::Number:
+        {
+            double X;
+            if (A.Type == FFilterValue::EType::Number) {
+                X = A.Number;
+            }
+            else if (A.Type == FFilterValue::EType::Bool) {
+                X = A.Bool ? 1.0 : 0.0;
+            }
+            else if (A.Type == FFilterValue::EType::String && FCString::IsNumeric(*A.String)) {
+                X = FCString::Atod(*A.String);
+            }
+            else {
+                return false;
+            }
+            Order = Sign(X - B.Number);
+            return true;
+        }
+        case FFilterValue::EType::Bool:
+        {
+            bool X;
+            if (A.Type == FFilterValue::EType::Bool) {
+                X = A.Bool;
+            }
+            else if (A.Type == FFilterValue::EType::Number) {
+                X = A.Number != 0.0;
+            }
+            else if (A.Type == FFilterValue::EType::String) {
+                X = A.String.ToBool();
+            }
+            else {
+                return false;
+            }
+            Order = (int32)X - (int32)B.Bool;
+            return true;
+        }
+        case FFilterValue::EType::String:
+            if (A.Type == FFilterValue::EType::String) {
+                Order = A.String.Compare(B.String, ESearchCase::IgnoreCase);
+                return true;
+            }
+            else if (A.Type == FFilterValue::EType::Number) {
+                Order = FString::SanitizeFloat(A.Number, 0).Compare(B.String, ESearchCase::IgnoreCase);
+                return true;
+            }
+            return false;
+        default:
+            return false;
+        }
+    }
+
+
+    // recursive descent parser. builds Nodes and Accessors of the expression directly.
+    struct FParser
+    {
+        enum class EToken : uint8
+        {
+            End,
+            Error,
+            LParen,
+            RParen,
+            And,
+            Or,
+            Not,
+            Op,
+            Word,
+            String,
+        };
+
+        TFilterExpr& Expr;
+        const FString& Source;
+        const FResolver& Resolver;
+        TMap<FString, int32> FieldIndices;
+        int32 Pos = 0;
+        FString Error;
+
+        EToken Token = EToken::End;
+        EOp TokenOp = EOp::Eq;
+        FString TokenText;
+        int32 TokenPos = 0;
+
+        FParser(TFilterExpr& InExpr, const FString& InSource, const FResolver& InResolver)
+            : Expr(InExpr), Source(InSource), Resolver(InResolver)
+        {}
+
+        bool Parse()
+        {
+            Next();
+            Expr.Root = ParseOr();
+            if (Expr.Root == INDEX_NONE) {
+                return false;
+            }
+            if (Token != EToken::End) {
+                return Fail(TEXT("unexpected token"));
+            }
+            return true;
+        }
+
+        bool Fail(const TCHAR* Message)
+        {
+            if (Error.IsEmpty()) {
+                Error = FString::Printf(TEXT("%s at %d"), Message, TokenPos);
+            }
+            return false;
+        }
+
+        static bool IsWordChar(TCHAR C)
+        {
+            return FChar::IsAlnum(C) || C == '_' || C == '.' || C == '*' || C == '?' || C == '/' || C == ':' || C == '-' || C == '+';
+        }
+
+        void Next()
+        {
+            const int32 Len = Source.Len();
+            while (Pos < Len && FChar::IsWhitespace(Source[Pos])) {
+                ++Pos;
+            }
+            TokenPos = Pos;
+            TokenText.Reset();
+            if (Pos >= Len) {
+                Token = EToken::End;
+                return;
+            }
+
+            const TCHAR C = Source[Pos];
+            const TCHAR C2 = Pos + 1 < Len ? Source[Pos + 1] : 0;
+            auto Op = [&](EOp InOp, int32 Size) {
+                Token = EToken::Op;
+                TokenOp = InOp;
+                Pos += Size;
+            };
+            switch (C) {
+            case '(': Token = EToken::LParen; ++Pos; return;
+            case ')': Token = EToken::RParen; ++Pos; return;
+            case '~': Op(EOp::Match, 1); return;
+            case '&':
+                if (C2 == '&') { Token = EToken::And; Pos += 2; return; }
+                break;
+            case '|':
+                if (C2 == '|') { Token = EToken::Or; Pos += 2; return; }
+                break;
+            case '=':
+                if (C2 == '=') { Op(EOp::Eq, 2); return; }
+                break;
+            case '!':
+                if (C2 == '=') { Op(EOp::Ne, 2); return; }
+                if (C2 == '~') { Op(EOp::NotMatch, 2); return; }
+                Token = EToken::Not;
+                ++Pos;
+                return;
+            case '<':
+                if (C2 == '=') { Op(EOp::Le, 2); return; }
+                Op(EOp::Lt, 1);
+                return;
+            case '>':
+                if (C2 == '=') { Op(EOp::Ge, 2); return; }
+                Op(EOp::Gt, 1);
+                return;
+            case '"':
+            case '\'':
+                ++Pos;
+                while (Pos < Len && Source[Pos] != C) {
+                    if (Source[Pos] == '\\' && Pos + 1 < Len) {
+                        ++Pos;
+                    }
+                    TokenText.AppendChar(Source[Pos++]);
+                }
+                if (Pos >= Len) {
+                    Token = EToken::Error;
+                    return;
+                }
+                ++Pos;
+                Token = EToken::String;
+                return;
+            default:
+                break;
+            }
+
+            if (IsWordChar(C)) {
+                while (Pos < Len && IsWordChar(Source[Pos])) {
+                    TokenText.AppendChar(Source[Pos++]);
+                }
+                Token = EToken::Word;
+                return;
+            }
+            Token = EToken::Error;
+        }
+
+        int32 AddNode(FNode&& Node)
+        {
+            return Expr.Nodes.Add(MoveTemp(Node));
+        }
+
+        int32 ParseOr()
+        {
+            int32 Lhs = ParseAnd();
+            while (Lhs != INDEX_NONE && Token == EToken::Or) {
+                Next();
+                int32 Rhs = ParseAnd();
+                if (Rhs == INDEX_NONE) {
+                    return INDEX_NONE;
+                }
+                FNode Node;
+                Node.Op = EOp::Or;
+                Node.Lhs = Lhs;
+                Node.Rhs = Rhs;
+                Lhs = AddNode(MoveTemp(Node));
+            }
+            return Lhs;
+        }
+
+        int32 ParseAnd()
+        {
+            int32 Lhs = ParseUnary();
+            while (Lhs != INDEX_NONE && Token == EToken::And) {
+                Next();
+                int32 Rhs = ParseUnary();
+                if (Rhs == INDEX_NONE) {
+                    return INDEX_NONE;
+                }
+                FNode Node;
+                Node.Op = EOp::And;
+                Node.Lhs = Lhs;
+                Node.Rhs = Rhs;
+                Lhs = AddNode(MoveTemp(Node));
+            }
+            return Lhs;
+        }
+
+        int32 ParseUnary()
+        {
+            if (Token == EToken::Not) {
+                Next();
+                int32 Operand = ParseUnary();
+                if (Operand == INDEX_NONE) {
+                    return INDEX_NONE;
+                }
+                FNode Node;
+                Node.Op = EOp::Not;
+                Node.Lhs = Operand;
+                return AddNode(MoveTemp(Node));
+            }
+            else if (Token == EToken::LParen) {
+                Next();
+                int32 Ret = ParseOr();
+                if (Ret == INDEX_NONE) {
+                    return INDEX_NONE;
+                }
+                if (Token != EToken::RParen) {
+                    Fail(TEXT("')' expected"));
+                    return INDEX_NONE;
+                }
+                Next();
+                return Ret;
+            }
+            return ParseCompare();
+        }
+
+        int32 ParseCompare()
+        {
+            if (Token != EToken::Word) {
+                Fail(TEXT("field name expected"));
+                return INDEX_NONE;
+            }
+
+            FNode Node;
+            if (int32* Found = FieldIndices.Find(TokenText)) {
+                Node.Field = *Found;
+            }
+            else {
+                auto Accessor = Resolver(TokenText);
+                if (!Accessor) {
+                    Fail(*FString::Printf(TEXT("unknown field '%s'"), *TokenText));
+                    return INDEX_NONE;
+                }
+                Node.Field = Expr.Accessors.Add(MoveTemp(Accessor));
+                FieldIndices.Add(TokenText, Node.Field);
+            }
+            Next();
+
+            if (Token != EToken::Op) {
+                Node.Op = EOp::Test;
+                return AddNode(MoveTemp(Node));
+            }
+            Node.Op = TokenOp;
+            Next();
+
+            if (Token == EToken::String) {
+                Node.Literal.SetString(TokenText);
+            }
+            else if (Token == EToken::Word && Node.Op != EOp::Match && Node.Op != EOp::NotMatch && FCString::IsNumeric(*TokenText)) {
+                Node.Literal.SetNumber(FCString::Atod(*TokenText));
+            }
+            else if (Token == EToken::Word && TokenText == TEXT("true")) {
+                Node.Literal.SetBool(true);
+            }
+            else if (Token == EToken::Word && TokenText == TEXT("false")) {
+                Node.Literal.SetBool(false);
+            }
+            else if (Token == EToken::Word) {
+                Node.Literal.SetString(TokenText);
+            }
+            else {
+                Fail(TEXT("value expected"));
+                return INDEX_NONE;
+            }
+            Next();
+            return AddNode(MoveTemp(Node));
+        }
+    };
+};
+
+
+// Compiled expressions keyed by source string.
+// The cache is simply flushed when it gets full; queries from a client tend to repeat the same few strings.
+template<class T>
+class TFilterCache
+{
+public:
+    using FExpr = TFilterExpr<T>;
+
+    explicit TFilterCache(typename FExpr::FResolver InResolver, int32 InCapacity = 256)
+        : Resolver(MoveTemp(InResolver))
+        , Capacity(InCapacity)
+    {}
+
+    TSharedPtr<FExpr> Get(const FString& Source, FString* OutError = nullptr)
+    {
+        if (auto* Found = Cache.Find(Source)) {
+            return *Found;
+        }
+        auto Ret = FExpr::Compile(Source, Resolver, OutError);
+        if (Ret) {
+            if (Cache.Num() >= Capacity) {
+                Cache.Reset();
+            }
+            Cache.Add(Source, Ret);
+        }
+        return Ret;
+    }
+
+    void Clear() { Cache.Reset(); }
+
+private:
+    typename FExpr::FResolver Resolver;
+    int32 Capacity;
+    TMap<FString, TSharedPtr<FExpr>> Cache;
+};
@@ -1,5 +1,10 @@
 ﻿#include "HTTPLink.h"
 #include "./JsonUtils.h"
+#include "./SpatialIndex.h"
+#include "./FilterExpr.h"
+#include "./StringTable.h"
+#include "./JsonArena.h"
+#include "./LogRing.h"
 
 #include "Editor/UnrealEdEngine.h"
 #include "UnrealEdGlobals.h"
@@ -16,6 +21,33 @@
 #include "Misc/FileHelper.h"
 #include "Serialization/MemoryWriter.h"
 #include "EditorClassUtils.h"
+#include "Editor.h"
+#include "LevelEditorViewport.h"
+#include "Engine/Selection.h"
+#include "Misc/PackageName.h"
+#include "UObject/StrongObjectPtr.h"
+#include "UObject/SavePackage.h"
+#include "FileHelpers.h"
+#include "ISourceControlModule.h"
+#include "ObjectTools.h"
+#include "AssetToolsModule.h"
+#include "AssetImportTask.h"
+#include "EditorFramework/AssetImportData.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Engine/Texture2D.h"
+#include "Factories/TextureFactory.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/App.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/Base64.h"
+#include "Misc/SecureHash.h"
+#include "Misc/ObjectThumbnail.h"
+#include "ImageUtils.h"
+#include <atomic>
 
 
 #if PLATFORM_WINDOWS
@@ -26,6 +58,9 @@
 #define LOCTEXT_NAMESPACE "FHTTPLinkModule"
 
 #pragma region Utilities
+using FActorFilter = TFilterExpr<AActor*>;
+using FAssetFilter = TFilterExpr<FAssetData>;
+
 static inline UWorld* GetEditorWorld()
 {
     return GEditor ? GEditor->GetEditorWorldContext().World() : nullptr;
@@ -56,11 +91,19 @@ inline ActorType* FindActor(UWorld* World, Cond&& C)
     return nullptr;
 }
 
+// 以下の特殊化以外の型は値を JSON として解釈する (例: guids=["...","..."])
 template<class T>
-inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, T& Dst);
+inline bool GetQueryParam(const FHTTPLinkRequest& Request, const char* Name, T& Dst)
+{
+    if (auto* V = Request.QueryParams.Find(Name)) {
+        JArray Tmp = JArray::Parse(FString::Printf(TEXT("[%s]"), **V));
+        return Tmp.Num() == 1 && JObject::FromJValue(Tmp.Data[0], Dst);
+    }
+    return false;
+}
 // bool
 template<>
-inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, bool& Dst)
+inline bool GetQueryParam(const FHTTPLinkRequest& Request, const char* Name, bool& Dst)
 {
     if (auto* V = Request.QueryParams.Find(Name)) {
         Dst = V->ToBool();
@@ -69,7 +112,7 @@ inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, b
 }
 // int32
 template<>
-inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, int& Dst)
+inline bool GetQueryParam(const FHTTPLinkRequest& Request, const char* Name, int& Dst)
 {
     if (auto* V = Request.QueryParams.Find(Name)) {
         if (V->StartsWith("0x"))
@@ -82,7 +125,7 @@ inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, i
 }
 // int64
 template<>
-inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, int64& Dst)
+inline bool GetQueryParam(const FHTTPLinkRequest& Request, const char* Name, int64& Dst)
 {
     if (auto* V = Request.QueryParams.Find(Name)) {
         if (V->StartsWith("0x"))
@@ -93,9 +136,19 @@ inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, i
     }
     return false;
 }
+// double
+template<>
+inline bool GetQueryParam(const FHTTPLinkRequest& Request, const char* Name, double& Dst)
+{
+    if (auto* V = Request.QueryParams.Find(Name)) {
+        Dst = FCString::Atod(**V);
+        return true;
+    }
+    return false;
+}
 // FString
 template<>
-inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, FString& Dst)
+inline bool GetQueryParam(const FHTTPLinkRequest& Request, const char* Name, FString& Dst)
 {
     if (auto* V = Request.QueryParams.Find(Name)) {
         Dst = *V;
@@ -105,7 +158,7 @@ inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, F
 }
 // FName
 template<>
-inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, FName& Dst)
+inline bool GetQueryParam(const FHTTPLinkRequest& Request, const char* Name, FName& Dst)
 {
     if (auto* V = Request.QueryParams.Find(Name)) {
         Dst = FName(*V);
@@ -115,7 +168,7 @@ inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, F
 }
 // FGuid
 template<>
-inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, FGuid& Dst)
+inline bool GetQueryParam(const FHTTPLinkRequest& Request, const char* Name, FGuid& Dst)
 {
     if (auto* V = Request.QueryParams.Find(Name)) {
         Dst = FGuid(*V);
@@ -125,7 +178,7 @@ inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, F
 }
 // FVector
 template<>
-inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, FVector& Dst)
+inline bool GetQueryParam(const FHTTPLinkRequest& Request, const char* Name, FVector& Dst)
 {
     if (auto* V = Request.QueryParams.Find(Name)) {
         float X, Y, Z;
@@ -138,7 +191,7 @@ inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, F
 }
 // FQuat
 template<>
-inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, FQuat& Dst)
+inline bool GetQueryParam(const FHTTPLinkRequest& Request, const char* Name, FQuat& Dst)
 {
     if (auto* V = Request.QueryParams.Find(Name)) {
         float X, Y, Z, W;
@@ -154,14 +207,14 @@ inline bool GetQueryParam(const FHttpServerRequest& Request, const char* Name, F
 struct ParamHandler
 {
     const char* Name;
-    TFunction<bool(const FHttpServerRequest& Request)> FromRequest;
+    TFunction<bool(const FHTTPLinkRequest& Request)> FromRequest;
     TFunction<bool(const JObject& Json)> FromJson;
 
     template<class T>
     ParamHandler(const char* InName, T& Dst)
         : Name(InName)
     {
-        FromRequest = [this, &Dst](const FHttpServerRequest& Request) {
+        FromRequest = [this, &Dst](const FHTTPLinkRequest& Request) {
             return GetQueryParam(Request, Name, Dst);
         };
         FromJson = [this, &Dst](const JObject& Json) {
@@ -170,36 +223,64 @@ struct ParamHandler
     }
 };
 
-template<class... T>
-static TArray<FString> GetQueryParamsImpl(const FHttpServerRequest& Request, T&&... PlaceholdersList)
+static TSharedPtr<FJsonObject> ParseJsonArgs(const FHTTPLinkRequest& Request)
 {
-    TArray<FString> Ret;
     FString JsonStr;
     if (GetQueryParam(Request, "json", JsonStr)) {
-        JObject JsonObj = JObject::Parse(JsonStr);
-        auto HandleJson = [&](auto& Placeholders) {
-            for (auto& P : Placeholders) {
-                if (P.FromJson(JsonObj)) {
-                    Ret.Add(P.Name);
-                }
-            }
-        };
-        ([&] { HandleJson(PlaceholdersList); } (), ...);
+        return JObject::Parse(JsonStr).Data;
     }
-    else {
-        auto HandleQueryParams = [&](auto& Placeholders) {
-            for (auto& P : Placeholders) {
-                if (P.FromRequest(Request)) {
-                    Ret.Add(P.Name);
-                }
-            }
-        };
-        ([&] { HandleQueryParams(PlaceholdersList); } (), ...);
+
+    int64 I = 0;
+    while (I < Request.Body.Num() && FChar::IsWhitespace(Request.Body[I])) {
+        ++I;
+    }
+    if (I < Request.Body.Num() && Request.Body[I] == '{') {
+        FUTF8ToTCHAR Converter((const ANSICHAR*)Request.Body.GetData(), (int32)Request.Body.Num());
+        return JObject::Parse(FString(Converter.Length(), Converter.Get())).Data;
+    }
+    return nullptr;
+}
+
+// 型付き引数 (in-process 呼び出し), json パラメータ, JSON のリクエストボディ のいずれか (この順で優先)
+// json パラメータとボディの解析は 1 リクエストにつき 1 回だけ行い、結果は Request.ParsedArgs に残す。
+// GetQueryParams() は引数ごとにこれを呼ぶので、大きなボディを毎回解析し直さないようにしている
+static bool GetJsonArgs(const FHTTPLinkRequest& Request, JObject& Dst)
+{
+    if (Request.Args) {
+        Dst = JObject(Request.Args);
+        return true;
+    }
+    if (!Request.ParsedArgs.IsSet()) {
+        Request.ParsedArgs = ParseJsonArgs(Request);
+    }
+    if (const TSharedPtr<FJsonObject>& Parsed = Request.ParsedArgs.GetValue()) {
+        Dst = JObject(Parsed);
+        return true;
     }
+    return false;
+}
+
+// 引数は GetJsonArgs() の JSON とクエリパラメータの両方から探す。
+// 同じ名前が両方にある場合は JSON 側が優先され、JSON にない引数はクエリパラメータから取る
+// /actor/transforms?session=<id> にボディで items を渡す、といった使い方ができる
+template<class... T>
+static TArray<FString> GetQueryParamsImpl(const FHTTPLinkRequest& Request, T&&... PlaceholdersList)
+{
+    TArray<FString> Ret;
+    JObject JsonObj;
+    const bool HasJson = GetJsonArgs(Request, JsonObj);
+    auto Handle = [&](auto& Placeholders) {
+        for (auto& P : Placeholders) {
+            if ((HasJson && P.FromJson(JsonObj)) || P.FromRequest(Request)) {
+                Ret.Add(P.Name);
+            }
+        }
+    };
+    ([&] { Handle(PlaceholdersList); } (), ...);
     return Ret;
 }
 template<class... T>
-static TArray<FString> GetQueryParams(const FHttpServerRequest& Request, std::initializer_list<ParamHandler>&& Placeholders, T&&... Additional)
+static TArray<FString> GetQueryParams(const FHTTPLinkRequest& Request, std::initializer_list<ParamHandler>&& Placeholders, T&&... Additional)
 {
     return GetQueryParamsImpl(Request, Placeholders, Forward<T>(Additional)...);
 }
@@ -237,71 +318,132 @@ static void AddAccessControl(FHttpServerResponse& Response)
     Response.Headers.Add("Access-Control-Allow-Origin", { "*" });
 }
 
-static bool Serve(const FHttpResultCallback& Result, const FString& Content = "", const FString& ContentType = "text/plain")
+static bool Serve(const FHTTPLinkResultCallback& Result, TArray<uint8>&& Content, const FString& ContentType, EHttpServerResponseCodes Code = EHttpServerResponseCodes::Ok)
 {
-    // FHttpServerResponse::Ok() は 204 No Content を返すので使わない方がいい
-    auto Response = FHttpServerResponse::Create(Content, ContentType);
-    Response->Code = EHttpServerResponseCodes::Ok;
-    AddAccessControl(*Response);
+    FHTTPLinkResponse Response;
+    Response.Code = Code;
+    Response.ContentType = ContentType;
+    Response.Body = MoveTemp(Content);
     Result(MoveTemp(Response));
     return true;
 }
 
-static bool Serve(const FHttpResultCallback& Result, TArray<uint8>&& Content, const FString& ContentType)
+static bool Serve(const FHTTPLinkResultCallback& Result, const FString& Content = "", const FString& ContentType = "text/plain")
 {
-    auto Response = FHttpServerResponse::Create(MoveTemp(Content), ContentType);
-    Response->Code = EHttpServerResponseCodes::Ok;
-    AddAccessControl(*Response);
-    Result(MoveTemp(Response));
-    return true;
+    FTCHARToUTF8 Converter(*Content);
+    return Serve(Result, TArray<uint8>((const uint8*)Converter.Get(), Converter.Length()), ContentType);
 }
 
 template<class T>
-static bool ServeJsonImpl(const FHttpResultCallback& Result, T&& Json)
+static TArray<uint8> SerializeJson(T&& Json)
 {
     TArray<uint8> Data;
     FMemoryWriter MemWriter(Data);
     FJsonSerializer::Serialize(Json, TJsonWriterFactory<UTF8CHAR>::Create(&MemWriter));
-    return Serve(Result, MoveTemp(Data), "application/json");
+    return Data;
+}
+
+// ハンドラはオブジェクトや配列以外 (数値や文字列) を返すこともあるので、値の種類を問わない形式で書き出す
+static TArray<uint8> SerializeJsonValue(const TSharedPtr<FJsonValue>& Json)
+{
+    TArray<uint8> Data;
+    FMemoryWriter MemWriter(Data);
+    FJsonSerializer::Serialize(Json, FString(), TJsonWriterFactory<UTF8CHAR>::Create(&MemWriter));
+    return Data;
+}
+
+// 構造化された結果のまま返す。エンコードは transport 側で行う
+static bool ServeJsonValue(const FHTTPLinkResultCallback& Result, TSharedPtr<FJsonValue>&& Json)
+{
+    FHTTPLinkResponse Response;
+    Response.ContentType = "application/json";
+    Response.Json = MoveTemp(Json);
+    Result(MoveTemp(Response));
+    return true;
+}
+// arena 上に構築したまま返す。エンコードは transport 側で行い、arena はレスポンスと一緒に解放される
+static bool ServeJson(const FHTTPLinkResultCallback& Result, TSharedRef<FJsonArenaDocument>&& Json)
+{
+    FHTTPLinkResponse Response;
+    Response.ContentType = "application/json";
+    Response.ArenaJson = MoveTemp(Json);
+    Result(MoveTemp(Response));
+    return true;
 }
-static bool ServeJson(const FHttpResultCallback& Result, JObject&& Json)
+static bool ServeJson(const FHTTPLinkResultCallback& Result, JObject&& Json)
 {
-    return ServeJsonImpl(Result, MoveTemp(Json));
+    return ServeJsonValue(Result, MakeShared<FJsonValueObject>(MoveTemp(Json.Data)));
 }
-static bool ServeJson(const FHttpResultCallback& Result, JArray&& Json)
+static bool ServeJson(const FHTTPLinkResultCallback& Result, JArray&& Json)
 {
-    return ServeJsonImpl(Result, MoveTemp(Json));
+    return ServeJsonValue(Result, MakeShared<FJsonValueArray>(MoveTemp(Json.Data)));
 }
-static bool ServeJson(const FHttpResultCallback& Result, std::initializer_list<JObject::Field>&& Fields)
+static bool ServeJson(const FHTTPLinkResultCallback& Result, std::initializer_list<JObject::Field>&& Fields)
 {
-    return ServeJsonImpl(Result, JObject(MoveTemp(Fields)));
+    return ServeJson(Result, JObject(MoveTemp(Fields)));
 }
-static bool ServeJson(const FHttpResultCallback& Result, bool R)
+static bool ServeJson(const FHTTPLinkResultCallback& Result, bool R)
 {
     return ServeJson(Result, { {"result", R} });
 }
 
-static bool ServeFile(const FHttpResultCallback& Result, FString FilePath, FString ContentType)
+static bool ServeFile(const FHTTPLinkResultCallback& Result, FString FilePath, FString ContentType)
 {
     TArray<uint8> Data;
     bool Ok = FFileHelper::LoadFileToArray(Data, *FilePath);
+    return Serve(Result, MoveTemp(Data), ContentType, Ok ? EHttpServerResponseCodes::Ok : EHttpServerResponseCodes::NotFound);
+}
 
-    auto Response = FHttpServerResponse::Create(MoveTemp(Data), ContentType);
-    Response->Code = Ok ? EHttpServerResponseCodes::Ok : EHttpServerResponseCodes::NotFound;
-    AddAccessControl(*Response);
+static bool ServeRetry(const FHTTPLinkResultCallback& Result, FString Location, int Second)
+{
+    FHTTPLinkResponse Response;
+    Response.Code = EHttpServerResponseCodes::Redirect;
+    Response.ContentType = "text/plain";
+    Response.Headers.Add("Location", { Location });
+    Response.Headers.Add("Retry-After", { FString::Printf(TEXT("%d"), Second) });
     Result(MoveTemp(Response));
     return true;
 }
 
-static bool ServeRetry(const FHttpResultCallback& Result, FString Location, int Second)
+
+// HTTP サーバーとコマンドの間のアダプタ
+// RelativePath は bind した route からの相対パスに書き換えられているので、Path には bind した route をそのまま使う
+static FHTTPLinkRequest ToLinkRequest(const FString& Route, const FHttpServerRequest& Request)
 {
-    auto Response = FHttpServerResponse::Create("", "text/plain");
-    Response->Code = EHttpServerResponseCodes::Redirect;
-    Response->Headers.Add("Location", { Location });
-    Response->Headers.Add("Retry-After", { FString::Printf(TEXT("%d"), Second) });
-    AddAccessControl(*Response);
-    Result(MoveTemp(Response));
-    return true;
+    FHTTPLinkRequest Ret;
+    Ret.Path = Route;
+    Ret.QueryParams = Request.QueryParams;
+    Ret.Body = Request.Body;
+    if (auto* ContentType = Request.Headers.Find(TEXT("Content-Type"))) {
+        Ret.ContentType = FString::Join(*ContentType, TEXT(","));
+    }
+    return Ret;
+}
+
+// 構造化された結果を Body にエンコードする
+static void EncodeResponseBody(FHTTPLinkResponse& Response)
+{
+    if (Response.ArenaJson) {
+        Response.Body = Response.ArenaJson->Write();
+        Response.ArenaJson.Reset();
+    }
+    else if (Response.Json) {
+        Response.Body = SerializeJsonValue(Response.Json);
+        Response.Json.Reset();
+    }
+}
+
+static TUniquePtr<FHttpServerResponse> ToHttpResponse(FHTTPLinkResponse&& Response)
+{
+    // FHttpServerResponse::Ok() は 204 No Content を返すので使わない方がいい
+    EncodeResponseBody(Response);
+    auto Ret = FHttpServerResponse::Create(MoveTemp(Response.Body), Response.ContentType);
+    Ret->Code = Response.Code;
+    for (auto& KVP : Response.Headers) {
+        Ret->Headers.Add(KVP.Key, MoveTemp(KVP.Value));
+    }
+    AddAccessControl(*Ret);
+    return Ret;
 }
 
 
@@ -364,76 +506,157 @@ static UEditorActorSubsystem* GetEditorActorSubsystem()
 
 
 #pragma region InternalTypes
-FHTTPLinkModule::FSimpleOutputDevice::FSimpleOutputDevice()
-    : Super()
+// /editor/exec の出力。リクエストごとに作るので、同時に実行されたコマンドの出力が混ざることはない
+// /log/tail からも見えるように LogRing にも流す
+class FExecOutputDevice : public FOutputDevice
 {
-}
+public:
+    explicit FExecOutputDevice(FLogRing* InRing)
+        : Ring(InRing)
+    {}
 
-void FHTTPLinkModule::FSimpleOutputDevice::Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const class FName& Category)
-{
-    Log += V;
-}
+    void Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const FName& Category) override
+    {
+        Lines.Emplace(V);
+        if (Ring) {
+            Ring->Write(V, Verbosity, Category);
+        }
+    }
+
+    TArray<FString> Lines;
+    FLogRing* Ring = nullptr;
+};
 
-void FHTTPLinkModule::FSimpleOutputDevice::Clear()
+// /log/tail の long-poll で待っているリクエスト
+struct FHTTPLinkModule::FLogTail
 {
-    Log.Empty();
-}
+    uint64 Cursor = 0;
+    int32 MaxRecords = 0;
+    double Deadline = 0.0;
+    FHTTPLinkResultCallback Result;
+};
 #pragma endregion InternalTypes
 
 
 #pragma region Startup / Shutdown
 void FHTTPLinkModule::StartupModule()
 {
-    GlobalLock = FPlatformProcess::NewInterprocessSynchObject(TEXT("Global\\ue-ist-httplink"), true);
-    if (GlobalLock) {
-        const uint64 MaxNanosecondsToWait = 10 * 1000000ULL; // 10ms
-        if (!GlobalLock->TryLock(MaxNanosecondsToWait)) {
-            // 他のプロセスが lock してる
-            FPlatformProcess::DeleteInterprocessSynchObject(GlobalLock);
-            GlobalLock = nullptr;
-        }
-    }
+    // コマンド登録
+    // HTTP を listen しないプロセスでも Call() で in-process から呼べるように常に登録しておく
+#define AddHandler(Path, Func) Handlers.Add(Path, [this](auto& Request, auto& OnComplete) { return Func(Request, OnComplete); })
 
-    if (GlobalLock) {
-        GConfig->SetString(TEXT("HTTPServer.Listeners"), TEXT("DefaultBindAddress"), TEXT("any"), GEngineIni);
+    AddHandler("/editor/exec", OnEditorExec);
+    AddHandler("/editor/screenshot", OnEditorScreenshot);
+    AddHandler("/log/tail", OnLogTail);
 
-        // HTTP の listening 開始
-        auto& HttpServerModule = FHttpServerModule::Get();
-        Router = HttpServerModule.GetHttpRouter(PORT);
+    AddHandler("/viewport/camera", OnViewportCamera);
+    AddHandler("/viewport/camera/set", OnViewportCameraSet);
 
-        TMap<FString, FHttpRequestHandler> Handlers;
-#define AddHandler(Path, Func) Handlers.Add(Path, [this](auto& Request, auto& OnComplete) { return Func(Request, OnComplete); })
+    AddHandler("/actor/list", OnActorList);
+    AddHandler("/actor/tree", OnActorTree);
+    AddHandler("/actor/select", OnActorSelect);
+    AddHandler("/actor/focus", OnActorFocus);
+    AddHandler("/actor/create", OnActorCreate);
+    AddHandler("/actor/delete", OnActorDelete);
+    AddHandler("/actor/merge", OnActorMerge);
+    AddHandler("/actor/transform", OnActorTransform);
+    AddHandler("/actor/transforms", OnActorTransforms);
+    AddHandler("/actor/query/box", OnActorQueryBox);
+    AddHandler("/actor/query/sphere", OnActorQuerySphere);
+    AddHandler("/actor/query/ray", OnActorQueryRay);
+    AddHandler("/actor/query/nearest", OnActorQueryNearest);
+    AddHandler("/actor/property/get", OnActorPropertyGet);
+    AddHandler("/actor/property/set", OnActorPropertySet);
+
+    AddHandler("/edit/begin", OnEditBegin);
+    AddHandler("/edit/end", OnEditEnd);
+    AddHandler("/edit/status", OnEditStatus);
 
-        AddHandler("/editor/exec", OnEditorExec);
-        AddHandler("/editor/screenshot", OnEditorScreenshot);
+    AddHandler("/level/new", OnLevelNew);
+    AddHandler("/level/load", OnLevelLoad);
+    AddHandler("/level/save", OnLevelSave);
 
-        AddHandler("/actor/list", OnActorList);
-        AddHandler("/actor/select", OnActorSelect);
-        AddHandler("/actor/focus", OnActorFocus);
-        AddHandler("/actor/create", OnActorCreate);
-        AddHandler("/actor/delete", OnActorDelete);
-        AddHandler("/actor/merge", OnActorMerge);
-        AddHandler("/actor/transform", OnActorTransform);
+    AddHandler("/asset/list", OnAssetList);
+    AddHandler("/asset/import", OnAssetImport);
+    AddHandler("/asset/dependencies", OnAssetDependencies);
+    AddHandler("/asset/referencers", OnAssetReferencers);
+    AddHandler("/asset/thumbnail", OnAssetThumbnail);
 
-        AddHandler("/level/new", OnLevelNew);
-        AddHandler("/level/load", OnLevelLoad);
-        AddHandler("/level/save", OnLevelSave);
+    AddHandler("/job/status", OnJobStatus);
+    AddHandler("/instances", OnInstances);
 
-        AddHandler("/asset/list", OnAssetList);
-        AddHandler("/asset/import", OnAssetImport);
+    AddHandler("/cache/stats", OnCacheStats);
+    AddHandler("/cache/clear", OnCacheClear);
 
-        AddHandler("/test", OnTest);
+    AddHandler("/upload", OnUpload);
+    AddHandler("/upload/begin", OnUploadBegin);
+    AddHandler("/upload/append", OnUploadAppend);
+    AddHandler("/upload/finish", OnUploadFinish);
+    AddHandler("/upload/delete", OnUploadDelete);
+
+    AddHandler("/test", OnTest);
 
 #undef AddHandler
 
+    // ログの取り込み。どのスレッドからでも直接書き込まれる
+    LogRing = MakeShared<FLogRing>(LogRingCapacity);
+    GLog->AddOutputDevice(LogRing.Get());
+
+    // 同一マシン上で複数のエディタが動いていることがあるので、ポートの範囲からロックを取れたものを使う
+    GConfig->GetInt(TEXT("HTTPLink"), TEXT("PortMin"), PortMin, GEngineIni);
+    GConfig->GetInt(TEXT("HTTPLink"), TEXT("PortMax"), PortMax, GEngineIni);
+    GConfig->SetString(TEXT("HTTPServer.Listeners"), TEXT("DefaultBindAddress"), TEXT("any"), GEngineIni);
+    auto& HttpServerModule = FHttpServerModule::Get();
+    for (int P = PortMin; P <= PortMax && !Router; ++P) {
+        PortLock = FPlatformProcess::NewInterprocessSynchObject(*FString::Printf(TEXT("Global\\ue-ist-httplink-%d"), P), true);
+        if (!PortLock) {
+            continue;
+        }
+        const uint64 MaxNanosecondsToWait = 10 * 1000000ULL; // 10ms
+        if (PortLock->TryLock(MaxNanosecondsToWait)) {
+#if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 1
+            // HTTPLink 以外のプロセスが使っているポートは飛ばす
+            Router = HttpServerModule.GetHttpRouter(P, true);
+#else
+            Router = HttpServerModule.GetHttpRouter(P);
+#endif
+            if (Router) {
+                Port = P;
+                break;
+            }
+            PortLock->Unlock();
+        }
+        // 他のプロセスが lock してる
+        FPlatformProcess::DeleteInterprocessSynchObject(PortLock);
+        PortLock = nullptr;
+    }
+
+    if (Router) {
+        // HTTP の listening 開始
         for (auto& KVP : Handlers) {
+            FHttpRequestHandler HttpHandler = [this, Route = KVP.Key](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete) {
+                return CallCached(ToLinkRequest(Route, Request), [OnComplete](FHTTPLinkResponse&& Response) {
+                    OnComplete(ToHttpResponse(MoveTemp(Response)));
+                    });
+            };
             HRoutes.Push(
-                Router->BindRoute(KVP.Key, EHttpServerRequestVerbs::VERB_GET | EHttpServerRequestVerbs::VERB_POST, KVP.Value)
+                Router->BindRoute(KVP.Key, EHttpServerRequestVerbs::VERB_GET | EHttpServerRequestVerbs::VERB_POST, HttpHandler)
             );
         }
         HttpServerModule.StartAllListeners();
+
+        UpdateInstanceRegistry();
+        HMapChange = FEditorDelegates::MapChange.AddLambda([this](uint32) { UpdateInstanceRegistry(); });
     }
 
+    // マップのロードは undo バッファをリセットするので、開いたままのトランザクションがあると assert する。ロード前に確定させる
+    HMapLoad = FEditorDelegates::OnMapLoad.AddLambda([this](const FString&, FCanLoadMap&) {
+        if (EditSession) {
+            UE_LOG(LogTemp, Warning, TEXT("HTTPLink: edit session %d was committed before loading a map"), EditSession->Id);
+            EndEditSession(false);
+        }
+        });
+
 
     // コンテキストメニュー登録
     auto& Extenders = FModuleManager::GetModuleChecked<FLevelEditorModule>(TEXT("LevelEditor")).GetAllLevelViewportContextMenuExtenders();
@@ -455,423 +678,4339 @@ void FHTTPLinkModule::ShutdownModule()
     }
     // 他への影響を考えて FHttpServerModule::Get().StopAllListeners() はしない
 
-    if (GlobalLock) {
-        GlobalLock->Unlock();
-        FPlatformProcess::DeleteInterprocessSynchObject(GlobalLock);
-        GlobalLock = nullptr;
+    if (EditSession) {
+        EndEditSession(false);
+    }
+    LogTails.Empty();
+    if (LogRing) {
+        GLog->RemoveOutputDevice(LogRing.Get());
+        LogRing.Reset();
+    }
+    SpatialIndex.Reset();
+    PropertyPaths.Reset();
+    QueryFilters.Reset();
+    Jobs.Empty();
+    Uploads.Empty();
+    ResponseCache.Reset();
+    AssetGraph.Reset();
+    ThumbnailCache.Reset();
+    CameraChannel.Reset();
+
+    if (HMapChange.IsValid()) {
+        FEditorDelegates::MapChange.Remove(HMapChange);
+        HMapChange = {};
+    }
+    if (HMapLoad.IsValid()) {
+        FEditorDelegates::OnMapLoad.Remove(HMapLoad);
+        HMapLoad = {};
+    }
+    if (PortLock) {
+        RemoveInstanceRegistry();
+        PortLock->Unlock();
+        FPlatformProcess::DeleteInterprocessSynchObject(PortLock);
+        PortLock = nullptr;
+        Port = 0;
     }
 }
 
 bool FHTTPLinkModule::Tick(float DeltaTime)
 {
+    TickJobs();
+    TickEditSession();
+    TickThumbnails();
+    TickLogTails();
+    TickCamera();
     return true;
 }
-#pragma endregion Startup / Shutdown
 
-
-#pragma region ContextMenu
-TSharedRef<FExtender> FHTTPLinkModule::BuildActorContextMenu(const TSharedRef<FUICommandList> CommandList, const TArray<AActor*> Actors)
+bool FHTTPLinkModule::Call(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
 {
-    TSharedPtr<FExtender> Extender = MakeShareable(new FExtender());
-    auto Build = [=](FMenuBuilder& Builder) {
-        Builder.AddMenuEntry(
-            LOCTEXT("CopyLinkAddress", "Copy Link Address"),
-            {},
-            FSlateIcon(FAppStyle::GetAppStyleSetName(), "Actors.Attach"),
-            FExecuteAction::CreateLambda([=]() { CopyLinkAddress(Actors); })
-        );
-    };
-    Extender->AddMenuExtension("ActorTypeTools", EExtensionHook::After, CommandList,
-        FMenuExtensionDelegate::CreateLambda(Build));
-    return Extender.ToSharedRef();
+    if (auto* Handler = Handlers.Find(Request.Path)) {
+        // upload=<id> が指定されていればアップロード済みのデータをボディとして渡す
+        if (Request.QueryParams.Contains(TEXT("upload")) && !Request.Path.StartsWith(TEXT("/upload"))) {
+            FHTTPLinkRequest Tmp = Request;
+            if (!ResolveUploadBody(Request, Tmp.Body)) {
+                return Serve(Result, {}, "text/plain", EHttpServerResponseCodes::NotFound);
+            }
+            // 解析済みの引数は差し替える前のボディのものなので捨てる
+            Tmp.ParsedArgs.Reset();
+            return (*Handler)(Tmp, Result);
+        }
+        return (*Handler)(Request, Result);
+    }
+    return Serve(Result, {}, "text/plain", EHttpServerResponseCodes::NotFound);
 }
 
-void FHTTPLinkModule::CopyLinkAddress(const TArray<AActor*> Actors)
+bool FHTTPLinkModule::Call(const FHTTPLinkRequest& Request, FHTTPLinkResponse& Response)
 {
-    if (!Actors.IsEmpty()) {
-        auto Str = FString::Printf(TEXT("http://localhost:%d/actor/focus?guid=%s"), PORT, *Actors[0]->GetActorGuid().ToString());
-        FPlatformApplicationMisc::ClipboardCopy(*Str);
-        //UE_LOG(LogTemp, Log, TEXT("FHTTPLinkModule::CopyLinkAddress(): %s"), *Str);
+    // 後のフレームで完了するコマンドはコールバックを保持するので、スタック上の変数は参照させない
+    auto Ret = MakeShared<TOptional<FHTTPLinkResponse>>();
+    Call(Request, [Ret](FHTTPLinkResponse&& R) {
+        Ret->Emplace(MoveTemp(R));
+        });
+    if (Ret->IsSet()) {
+        Response = MoveTemp(Ret->GetValue());
+        // in-process の呼び出し元は Json を見るので、arena 上の結果は通常の DOM に変換して渡す
+        if (Response.ArenaJson) {
+            Response.Json = Response.ArenaJson->ToJsonValue();
+            Response.ArenaJson.Reset();
+        }
+        return true;
     }
+    return false;
 }
-#pragma endregion ContextMenu
+#pragma endregion Startup / Shutdown
 
 
-#pragma region Editor Commands
-bool FHTTPLinkModule::OnEditorExec(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
+#pragma region Jobs
+// 複数フレームにまたがるコマンド
+// Step はゲームスレッドで毎 tick 呼ばれ、true を返すと完了する。ワーカースレッドから触ってよいのは Progress のみ
+struct FHTTPLinkModule::FJob
 {
-    FString Command;
-    GetQueryParams(Request, { {"c", Command}, {"command", Command} });
-    if (!Command.IsEmpty()) {
-        Outputs.Clear();
-        GUnrealEd->Exec(GetEditorWorld(), *Command, Outputs);
+    enum class EState : uint8
+    {
+        Running,
+        Succeeded,
+        Failed,
+    };
+
+    int32 Id = 0;
+    FString Type;
+    FString Phase;
+    std::atomic<float> Progress{ 0.0f }; // 0-1
+    EState State = EState::Running;
+    FString Error;
+    JObject Result;
+    double StartTime = 0.0;
+    double EndTime = 0.0;
+    TFunction<bool(FJob& Job)> Step;
+
+    void SetPhase(const TCHAR* InPhase, float InProgress)
+    {
+        Phase = InPhase;
+        Progress = InProgress;
     }
-    return ServeJson(Result, { {"outputs", Outputs.Log} });
-}
 
-bool FHTTPLinkModule::OnEditorScreenshot(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
-{
-    static const FString ScreenshotDir = FPaths::ProjectIntermediateDir();
-    static const FString ScreenshotPath = ScreenshotDir + TEXT("screenshot.png");
+    // Step から return Job.Fail(...) で使う
+    bool Fail(const FString& Message)
+    {
+        State = EState::Failed;
+        Error = Message;
+        return true;
+    }
 
-    auto& FS = IPlatformFile::GetPlatformPhysical();
-    auto Timestamp = FS.GetTimeStampLocal(*ScreenshotPath);
-    if (Timestamp == FDateTime::MinValue()) {
-        if (!FS.CreateDirectoryTree(*ScreenshotDir)) {
-            return Serve(Result);
+    JObject ToJson() const
+    {
+        static const TCHAR* StateNames[] = { TEXT("running"), TEXT("succeeded"), TEXT("failed") };
+        JObject Ret({
+            { "id", Id },
+            { "type", Type },
+            { "state", StateNames[(int)State] },
+            { "phase", Phase },
+            { "percentage", Progress.load() * 100.0f },
+            { "elapsed", (State == EState::Running ? FPlatformTime::Seconds() : EndTime) - StartTime },
+            });
+        if (State == EState::Failed) {
+            Ret["error"] = Error;
         }
+        if (Result.IsValid()) {
+            Ret["result"] = Result.Data;
+        }
+        return Ret;
     }
+};
 
-    double TimeGap = (FDateTime::Now() - Timestamp).GetTotalSeconds();
-    if (TimeGap < 5.0) {
-        // 5 秒以内に撮影されたスクリーンショットならそれを返す
-        return ServeFile(Result, ScreenshotPath, "image/png");
+TSharedRef<FHTTPLinkModule::FJob> FHTTPLinkModule::StartJob(const FString& Type, TFunction<bool(FJob& Job)>&& Step)
+{
+    auto Job = MakeShared<FJob>();
+    Job->Id = ++LastJobId;
+    Job->Type = Type;
+    Job->StartTime = FPlatformTime::Seconds();
+    Job->Step = MoveTemp(Step);
+    Jobs.Add(Job->Id, Job);
+    return Job;
+}
+
+void FHTTPLinkModule::TickJobs()
+{
+    // Step の中で新たなジョブが追加されることがあるので、コピーしてから回す
+    TArray<TSharedPtr<FJob>> Running;
+    for (auto& KVP : Jobs) {
+        if (KVP.Value->State == FJob::EState::Running) {
+            Running.Add(KVP.Value);
+        }
     }
-    else {
-        if (!bScreenshotInProgress) {
-            if (!HScreenshot.IsValid()) {
-                HScreenshot = FScreenshotRequest::OnScreenshotRequestProcessed().AddRaw(this, &FHTTPLinkModule::OnScreenshotProcessed);
+    for (auto& Job : Running) {
+        if (Job->Step(*Job)) {
+            if (Job->State == FJob::EState::Running) {
+                Job->State = FJob::EState::Succeeded;
+                Job->Progress = 1.0f;
             }
+            Job->EndTime = FPlatformTime::Seconds();
+            Job->Step = {};
+        }
+    }
 
-            bool ShowUI = true;
-            GetQueryParams(Request, { {"ui", ShowUI} });
-            // 撮影リクエスト発行
-            FScreenshotRequest::RequestScreenshot(ScreenshotPath, ShowUI, false);
-            bScreenshotInProgress = true;
-
-            // エディタがアクティブなウィンドウでないと撮影処理が進まないっぽいので…
-            MakeEditorWindowForeground();
-            GEditor->RedrawLevelEditingViewports();
+    // 完了したジョブは直近のものだけ残す
+    const int32 MaxFinishedJobs = 64;
+    int32 NumFinished = 0;
+    for (auto& KVP : Jobs) {
+        if (KVP.Value->State != FJob::EState::Running) {
+            ++NumFinished;
         }
+    }
+    for (auto It = Jobs.CreateIterator(); It && NumFinished > MaxFinishedJobs; ++It) {
+        if (It->Value->State != FJob::EState::Running) {
+            It.RemoveCurrent();
+            --NumFinished;
+        }
+    }
+}
 
-        // 撮影が完了していないので Retry-After を返してリトライしてもらう
-        return ServeRetry(Result, "/editor/screenshot", 2);
+// /job/status?id=n
+// id を省略した場合は全ジョブ
+bool FHTTPLinkModule::OnJobStatus(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    int Id = 0;
+    GetQueryParams(Request, {
+        { "id", Id },
+        });
+
+    if (Id == 0) {
+        JArray Json;
+        for (auto& KVP : Jobs) {
+            Json.Add(KVP.Value->ToJson());
+        }
+        return ServeJson(Result, MoveTemp(Json));
     }
+    else if (auto* Job = Jobs.Find(Id)) {
+        return ServeJson(Result, (*Job)->ToJson());
+    }
+    return ServeJson(Result, false);
 }
 
-void FHTTPLinkModule::OnScreenshotProcessed()
+static JObject MakeJobStarted(int32 Id)
 {
-    bScreenshotInProgress = false;
+    return JObject({
+        { "result", true },
+        { "job", Id },
+        });
 }
-#pragma endregion Editor Commands
+#pragma endregion Jobs
 
 
-#pragma region Actor Commands
-static JObject MakeActorSummary(AActor* Actor)
+#pragma region Edit Sessions
+// 編集セッション
+// /edit/begin で undo のトランザクションを開いたままにし、session=<id> を付けた /actor/transform, /actor/transforms,
+// /actor/property/set の変更をすべてそのトランザクションにまとめる。/edit/end で閉じると undo 1 回分になる。
+// 外部ギズモのドラッグなどで 60Hz の更新を送っても undo バッファが溢れず、Modify() も各オブジェクトにつき最初の 1 回だけで済む。
+// トランザクションはエディタ全体で 1 つなので同時に開けるセッションは 1 つだけ。開いている間のエディタ上の操作も同じ undo に入る。
+// EditSessionTimeout 秒間更新がなければ自動的に確定する
+struct FHTTPLinkModule::FEditSession
 {
-    if (!Actor) {
-        return {};
+    int32 Id = 0;
+    FString Description;
+    int32 TransactionIndex = INDEX_NONE;
+    double StartTime = 0.0;
+    double LastUpdateTime = 0.0;
+    int32 NumUpdates = 0;
+    TSet<TWeakObjectPtr<UObject>> Modified;
+
+    // セッション中は最初の 1 回だけ Modify() する。セッション外では毎回
+    static void Modify(FEditSession* Session, UObject* Object)
+    {
+        if (!Session) {
+            Object->Modify();
+        }
+        else if (!Session->Modified.Contains(Object)) {
+            Object->Modify();
+            Session->Modified.Add(Object);
+        }
     }
 
-    JObject Ret({
-        { "typeName", Actor->GetClass()->GetName() },
-        { "label", Actor->GetActorLabel() },
-        { "name", Actor->GetFName() },
-        { "guid", Actor->GetActorGuid() },
-        { "transform", Actor->GetActorTransform() },
-        });
+    JObject ToJson() const
+    {
+        return JObject({
+            { "session", Id },
+            { "description", Description },
+            { "updates", NumUpdates },
+            { "objects", Modified.Num() },
+            { "elapsed", FPlatformTime::Seconds() - StartTime },
+            });
+    }
+};
 
-    JArray Components;
-    for (auto& C : Actor->GetComponents()) {
-        Components.Add(JObject({
-            { "typeName", C->GetClass()->GetName() },
-            { "name", C->GetName() },
-            }));
+// session=<id> が指定されていればそのセッションを返す
+// 指定されたセッションが開いていない場合は false
+bool FHTTPLinkModule::ResolveEditSession(const FHTTPLinkRequest& Request, FEditSession*& OutSession)
+{
+    OutSession = nullptr;
+    int32 Id = 0;
+    GetQueryParams(Request, {
+        { "session", Id },
+        });
+    if (!Id) {
+        return true;
     }
-    Ret["components"] = Components;
-    return Ret;
+    if (!EditSession || EditSession->Id != Id) {
+        return false;
+    }
+    OutSession = EditSession.Get();
+    OutSession->LastUpdateTime = FPlatformTime::Seconds();
+    ++OutSession->NumUpdates;
+    return true;
 }
 
-bool FHTTPLinkModule::OnActorList(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
+TSharedPtr<FJsonObject> FHTTPLinkModule::EndEditSession(bool Cancel)
 {
-    JArray Json;
-    EachActor(GetEditorWorld(), [&](AActor* Actor) {
-        Json.Add(MakeActorSummary(Actor));
-        });
-    return ServeJson(Result, MoveTemp(Json));
+    JObject Ret = EditSession->ToJson();
+    const bool bModified = EditSession->Modified.Num() > 0;
+    const int32 TransactionIndex = EditSession->TransactionIndex;
+    EditSession.Reset();
+    // 終了処理中は GEditor が既にないことがある
+    if (GEditor) {
+        if (Cancel && !bModified) {
+            // 何も記録していないトランザクションを閉じてから undo すると、セッションと無関係な直前の操作が巻き戻されてしまう
+            GEditor->CancelTransaction(TransactionIndex);
+        }
+        else {
+            GEditor->EndTransaction();
+            if (Cancel) {
+                // 閉じたトランザクションを undo して変更を巻き戻す
+                GEditor->UndoTransaction();
+            }
+        }
+        GEditor->RedrawLevelEditingViewports();
+    }
+    Ret["result"] = true;
+    Ret["canceled"] = Cancel;
+    return Ret.Data;
 }
 
-static TFunction<AActor* ()> GetActorFinder(const FHttpServerRequest& Request, std::initializer_list<ParamHandler>&& Additional = {})
+void FHTTPLinkModule::TickEditSession()
 {
-    auto* World = GetEditorWorld();
-    if (!World) {
-        return {};
+    if (EditSession && FPlatformTime::Seconds() - EditSession->LastUpdateTime > EditSessionTimeout) {
+        UE_LOG(LogTemp, Warning, TEXT("HTTPLink: edit session %d timed out and was committed"), EditSession->Id);
+        EndEditSession(false);
     }
+}
 
-    FGuid GUID;
+static bool ServeInvalidSession(const FHTTPLinkResultCallback& Result)
+{
+    return ServeJson(Result, { { "result", false }, { "error", "invalid session" } });
+}
+
+// /edit/begin?description=Gizmo Drag
+bool FHTTPLinkModule::OnEditBegin(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    if (EditSession) {
+        return ServeJson(Result, { { "result", false }, { "error", "another session is open" }, { "session", EditSession->Id } });
+    }
+
+    FString Description = TEXT("HTTPLink Edit");
+    GetQueryParams(Request, {
+        { "description", Description },
+        });
+
+    EditSession = MakeShared<FEditSession>();
+    EditSession->Id = ++LastEditSessionId;
+    EditSession->Description = Description;
+    EditSession->TransactionIndex = GEditor->BeginTransaction(TEXT("HTTPLink"), FText::FromString(Description), nullptr);
+    EditSession->StartTime = EditSession->LastUpdateTime = FPlatformTime::Seconds();
+    return ServeJson(Result, { { "result", true }, { "session", EditSession->Id } });
+}
+
+// /edit/end?session=id&cancel=false
+// cancel=true の場合はセッション中の変更を全て巻き戻す
+bool FHTTPLinkModule::OnEditEnd(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    bool Cancel = false;
+    GetQueryParams(Request, {
+        { "cancel", Cancel },
+        });
+
+    FEditSession* Session;
+    if (!ResolveEditSession(Request, Session) || !Session) {
+        return ServeInvalidSession(Result);
+    }
+    return ServeJson(Result, JObject(EndEditSession(Cancel)));
+}
+
+// /edit/status
+bool FHTTPLinkModule::OnEditStatus(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    if (!EditSession) {
+        return ServeJson(Result, { { "active", false } });
+    }
+    JObject Json = EditSession->ToJson();
+    Json["active"] = true;
+    return ServeJson(Result, MoveTemp(Json));
+}
+#pragma endregion Edit Sessions
+
+
+#pragma region Instances
+// 同一マシン上で listen しているエディタのレジストリ
+// インスタンスごとに <UserTempDir>/HTTPLink/Instances/<pid>.json を置く。終了したプロセスのエントリは /instances で掃除する
+static FString GetInstanceRegistryDir()
+{
+    return FPaths::Combine(FPlatformProcess::UserTempDir(), TEXT("HTTPLink"), TEXT("Instances"));
+}
+
+static FString GetInstanceRegistryFile(uint32 ProcessId)
+{
+    return FPaths::Combine(GetInstanceRegistryDir(), FString::Printf(TEXT("%u.json"), ProcessId));
+}
+
+void FHTTPLinkModule::UpdateInstanceRegistry()
+{
+    if (!Port) {
+        return;
+    }
+
+    UWorld* World = GetEditorWorld();
+    JObject Json({
+        { "pid", FPlatformProcess::GetCurrentProcessId() },
+        { "port", Port },
+        { "project", FApp::GetProjectName() },
+        { "projectFile", FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()) },
+        { "map", World ? World->GetOutermost()->GetName() : FString() },
+        { "engine", FEngineVersion::Current().ToString() },
+        });
+
+    // 読み手が書きかけのファイルを見ないように、一時ファイルに書いてから置き換える
+    const FString Path = GetInstanceRegistryFile(FPlatformProcess::GetCurrentProcessId());
+    const FString TmpPath = Path + TEXT(".tmp");
+    if (FFileHelper::SaveArrayToFile(SerializeJson(Json.Data.ToSharedRef()), *TmpPath)) {
+        IFileManager::Get().Move(*Path, *TmpPath, true, true);
+    }
+}
+
+void FHTTPLinkModule::RemoveInstanceRegistry()
+{
+    IFileManager::Get().Delete(*GetInstanceRegistryFile(FPlatformProcess::GetCurrentProcessId()), false, true, true);
+}
+
+// /instances
+// 同一マシン上で HTTPLink が listen しているエディタの一覧
+bool FHTTPLinkModule::OnInstances(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    const uint32 CurrentProcessId = FPlatformProcess::GetCurrentProcessId();
+    TArray<FString> Files;
+    IFileManager::Get().FindFiles(Files, *(GetInstanceRegistryDir() / TEXT("*.json")), true, false);
+
+    JArray Json;
+    for (auto& File : Files) {
+        const FString Path = GetInstanceRegistryDir() / File;
+        FString Str;
+        int64 ProcessId = 0;
+        JObject Instance;
+        if (FFileHelper::LoadFileToString(Str, *Path)) {
+            Instance = JObject::Parse(Str);
+        }
+        if (Instance.IsValid() && Instance.Get("pid", ProcessId) && FPlatformProcess::IsApplicationRunning((uint32)ProcessId)) {
+            Instance["self"] = (uint32)ProcessId == CurrentProcessId;
+            Json.Add(MoveTemp(Instance));
+        }
+        else {
+            IFileManager::Get().Delete(*Path, false, true, true);
+        }
+    }
+    return ServeJson(Result, MoveTemp(Json));
+}
+#pragma endregion Instances
+
+
+#pragma region Response Cache
+// 冪等な GET route のエンコード済みレスポンスのキャッシュ
+// キーは route + 正規化したクエリパラメータで、エントリは作成時のワールド / アセットレジストリの世代を持つ。
+// 世代が変わったエントリは次の参照時に捨てられるので、何かが変わるまではハンドラを一切呼ばずにバイト列を返せる。
+// 合計サイズが ResponseCacheCapacity を超えたら最も古く参照されたものから捨てる
+struct FHTTPLinkModule::FResponseCache
+{
+    enum class ESource : uint8
+    {
+        World,
+        Registry,
+    };
+
+    struct FEntry
+    {
+        TArray<uint8> Body;
+        FString ContentType;
+        uint64 Generation = 0;
+        uint64 LastUse = 0;
+    };
+
+    TMap<FString, ESource> Routes;
+    TMap<FString, FEntry> Entries;
+    int64 Capacity = 0;
+    int64 TotalBytes = 0;
+    uint64 UseCounter = 0;
+    uint64 WorldGeneration = 1;
+    uint64 RegistryGeneration = 1;
+    int64 NumHits = 0;
+    int64 NumMisses = 0;
+    int64 NumStale = 0;
+    int64 NumEvictions = 0;
+
+    FDelegateHandle HActorAdded;
+    FDelegateHandle HActorDeleted;
+    FDelegateHandle HActorMoved;
+    FDelegateHandle HObjectModified;
+    FDelegateHandle HPropertyChanged;
+    FDelegateHandle HMapChange;
+    FDelegateHandle HUndoRedo;
+    FDelegateHandle HAssetAdded;
+    FDelegateHandle HAssetRemoved;
+    FDelegateHandle HAssetRenamed;
+    FDelegateHandle HFilesLoaded;
+
+    FResponseCache(int64 InCapacity)
+        : Capacity(InCapacity)
+    {
+        Routes = {
+            { TEXT("/actor/list"), ESource::World },
+            { TEXT("/actor/tree"), ESource::World },
+            { TEXT("/asset/list"), ESource::Registry },
+        };
+
+        // ワールドの変更。OnObjectModified は Modify() を通る編集 (ラベルの変更なども含む) を全て拾う
+        auto BumpWorld = [this]() { ++WorldGeneration; };
+        HActorAdded = GEngine->OnLevelActorAdded().AddLambda([BumpWorld](AActor*) { BumpWorld(); });
+        HActorDeleted = GEngine->OnLevelActorDeleted().AddLambda([BumpWorld](AActor*) { BumpWorld(); });
+        HActorMoved = GEngine->OnActorMoved().AddLambda([BumpWorld](AActor*) { BumpWorld(); });
+        HObjectModified = FCoreUObjectDelegates::OnObjectModified.AddLambda([BumpWorld](UObject*) { BumpWorld(); });
+        HPropertyChanged = FCoreUObjectDelegates::OnObjectPropertyChanged.AddLambda([BumpWorld](UObject*, FPropertyChangedEvent&) { BumpWorld(); });
+        HMapChange = FEditorDelegates::MapChange.AddLambda([BumpWorld](uint32) { BumpWorld(); });
+        HUndoRedo = FEditorDelegates::PostUndoRedo.AddLambda(BumpWorld);
+
+        // アセットレジストリの変更
+        auto BumpRegistry = [this]() { ++RegistryGeneration; };
+        auto& Registry = GetAssetRegistry();
+        HAssetAdded = Registry.OnAssetAdded().AddLambda([BumpRegistry](const FAssetData&) { BumpRegistry(); });
+        HAssetRemoved = Registry.OnAssetRemoved().AddLambda([BumpRegistry](const FAssetData&) { BumpRegistry(); });
+        HAssetRenamed = Registry.OnAssetRenamed().AddLambda([BumpRegistry](const FAssetData&, const FString&) { BumpRegistry(); });
+        HFilesLoaded = Registry.OnFilesLoaded().AddLambda(BumpRegistry);
+    }
+
+    ~FResponseCache()
+    {
+        if (GEngine) {
+            GEngine->OnLevelActorAdded().Remove(HActorAdded);
+            GEngine->OnLevelActorDeleted().Remove(HActorDeleted);
+            GEngine->OnActorMoved().Remove(HActorMoved);
+        }
+        FCoreUObjectDelegates::OnObjectModified.Remove(HObjectModified);
+        FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(HPropertyChanged);
+        FEditorDelegates::MapChange.Remove(HMapChange);
+        FEditorDelegates::PostUndoRedo.Remove(HUndoRedo);
+        if (auto* AssetRegistryModule = FModuleManager::GetModulePtr<FAssetRegistryModule>("AssetRegistry")) {
+            auto& Registry = AssetRegistryModule->Get();
+            Registry.OnAssetAdded().Remove(HAssetAdded);
+            Registry.OnAssetRemoved().Remove(HAssetRemoved);
+            Registry.OnAssetRenamed().Remove(HAssetRenamed);
+            Registry.OnFilesLoaded().Remove(HFilesLoaded);
+        }
+    }
+
+    // キャッシュ対象でなければ false
+    // ボディや型付き引数を持つリクエストと nocache=true のリクエストは対象外
+    bool MakeKey(const FHTTPLinkRequest& Request, FString& OutKey, uint64& OutGeneration) const
+    {
+        const ESource* Source = Routes.Find(Request.Path);
+        if (!Source || Request.Args || Request.Body.Num() || Request.QueryParams.Contains(TEXT("upload"))) {
+            return false;
+        }
+        if (const FString* NoCache = Request.QueryParams.Find(TEXT("nocache"))) {
+            if (*NoCache == TEXT("true") || *NoCache == TEXT("1")) {
+                return false;
+            }
+        }
+
+        // パラメータの順番が違っても同じキーになるように並べる
+        TArray<TPair<FString, FString>> Params;
+        for (auto& KVP : Request.QueryParams) {
+            if (KVP.Key != TEXT("nocache")) {
+                Params.Emplace(KVP.Key, KVP.Value);
+            }
+        }
+        Params.Sort([](auto& A, auto& B) { return A.Key < B.Key; });
+        OutKey = Request.Path;
+        for (auto& P : Params) {
+            OutKey += TEXT("\n");
+            OutKey += P.Key;
+            OutKey += TEXT("=");
+            OutKey += P.Value;
+        }
+        OutGeneration = *Source == ESource::World ? WorldGeneration : RegistryGeneration;
+        return true;
+    }
+
+    const FEntry* Find(const FString& Key, uint64 Generation)
+    {
+        FEntry* Entry = Entries.Find(Key);
+        if (!Entry) {
+            ++NumMisses;
+            return nullptr;
+        }
+        if (Entry->Generation != Generation) {
+            ++NumStale;
+            ++NumMisses;
+            TotalBytes -= Entry->Body.Num();
+            Entries.Remove(Key);
+            return nullptr;
+        }
+        ++NumHits;
+        Entry->LastUse = ++UseCounter;
+        return Entry;
+    }
+
+    void Store(const FString& Key, uint64 Generation, const TArray<uint8>& Body, const FString& ContentType)
+    {
+        // 大きすぎるものは入れない (他のエントリを全部追い出すことになるので)
+        if (Body.Num() > Capacity / 4) {
+            return;
+        }
+        if (FEntry* Old = Entries.Find(Key)) {
+            TotalBytes -= Old->Body.Num();
+        }
+        FEntry& Entry = Entries.Add(Key);
+        Entry.Body = Body;
+        Entry.ContentType = ContentType;
+        Entry.Generation = Generation;
+        Entry.LastUse = ++UseCounter;
+        TotalBytes += Body.Num();
+
+        while (TotalBytes > Capacity && Entries.Num() > 1) {
+            const FString* Oldest = nullptr;
+            uint64 OldestUse = MAX_uint64;
+            for (auto& KVP : Entries) {
+                if (KVP.Value.LastUse < OldestUse) {
+                    OldestUse = KVP.Value.LastUse;
+                    Oldest = &KVP.Key;
+                }
+            }
+            FString OldestKey = *Oldest;
+            TotalBytes -= Entries[OldestKey].Body.Num();
+            Entries.Remove(OldestKey);
+            ++NumEvictions;
+        }
+    }
+
+    void Clear()
+    {
+        Entries.Empty();
+        TotalBytes = 0;
+    }
+
+    JObject ToJson() const
+    {
+        return JObject({
+            { "entries", Entries.Num() },
+            { "bytes", TotalBytes },
+            { "capacity", Capacity },
+            { "hits", NumHits },
+            { "misses", NumMisses },
+            { "stale", NumStale },
+            { "evictions", NumEvictions },
+            { "worldGeneration", (int64)WorldGeneration },
+            { "registryGeneration", (int64)RegistryGeneration },
+            });
+    }
+};
+
+FHTTPLinkModule::FResponseCache& FHTTPLinkModule::GetResponseCache()
+{
+    if (!ResponseCache) {
+        ResponseCache = MakeShared<FResponseCache>(ResponseCacheCapacity);
+    }
+    return *ResponseCache;
+}
+
+// HTTP からの呼び出し。キャッシュ対象の route はエンコード済みのレスポンスを返すか、結果をキャッシュに入れる
+bool FHTTPLinkModule::CallCached(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    auto& Cache = GetResponseCache();
+    FString Key;
+    uint64 Generation;
+    if (!Cache.MakeKey(Request, Key, Generation)) {
+        return Call(Request, Result);
+    }
+
+    if (auto* Entry = Cache.Find(Key, Generation)) {
+        FHTTPLinkResponse Response;
+        Response.ContentType = Entry->ContentType;
+        Response.Body = Entry->Body;
+        Response.Headers.Add(TEXT("X-HTTPLink-Cache"), { TEXT("hit") });
+        Result(MoveTemp(Response));
+        return true;
+    }
+
+    // 後のフレームで完了するハンドラもあるので Cache はここで参照せず、完了時に取り直す
+    return Call(Request, [this, Key, Generation, Result](FHTTPLinkResponse&& Response) {
+        if (Response.Code == EHttpServerResponseCodes::Ok) {
+            EncodeResponseBody(Response);
+            GetResponseCache().Store(Key, Generation, Response.Body, Response.ContentType);
+        }
+        Response.Headers.Add(TEXT("X-HTTPLink-Cache"), { TEXT("miss") });
+        Result(MoveTemp(Response));
+        });
+}
+
+// /cache/stats
+bool FHTTPLinkModule::OnCacheStats(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    JObject Json = GetResponseCache().ToJson();
+    Json["thumbnails"] = GetThumbnailCache().ToJson();
+    return ServeJson(Result, MoveTemp(Json));
+}
+
+// /cache/clear
+bool FHTTPLinkModule::OnCacheClear(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    GetResponseCache().Clear();
+    if (ThumbnailCache) {
+        ThumbnailCache->ClearMemory();
+    }
+    return ServeJson(Result, true);
+}
+#pragma endregion Response Cache
+
+
+#pragma region ContextMenu
+TSharedRef<FExtender> FHTTPLinkModule::BuildActorContextMenu(const TSharedRef<FUICommandList> CommandList, const TArray<AActor*> Actors)
+{
+    TSharedPtr<FExtender> Extender = MakeShareable(new FExtender());
+    auto Build = [=](FMenuBuilder& Builder) {
+        Builder.AddMenuEntry(
+            LOCTEXT("CopyLinkAddress", "Copy Link Address"),
+            {},
+            FSlateIcon(FAppStyle::GetAppStyleSetName(), "Actors.Attach"),
+            FExecuteAction::CreateLambda([=]() { CopyLinkAddress(Actors); })
+        );
+    };
+    Extender->AddMenuExtension("ActorTypeTools", EExtensionHook::After, CommandList,
+        FMenuExtensionDelegate::CreateLambda(Build));
+    return Extender.ToSharedRef();
+}
+
+void FHTTPLinkModule::CopyLinkAddress(const TArray<AActor*> Actors)
+{
+    if (!Actors.IsEmpty()) {
+        auto Str = FString::Printf(TEXT("http://localhost:%d/actor/focus?guid=%s"), Port, *Actors[0]->GetActorGuid().ToString());
+        FPlatformApplicationMisc::ClipboardCopy(*Str);
+        //UE_LOG(LogTemp, Log, TEXT("FHTTPLinkModule::CopyLinkAddress(): %s"), *Str);
+    }
+}
+#pragma endregion ContextMenu
+
+
+#pragma region Editor Commands
+// コンソールコマンドを 1 つ実行し、その出力と所要時間を返す
+static JObject ExecCommand(FLogRing* Ring, const FString& Command)
+{
+    FExecOutputDevice Outputs(Ring);
+    const double Begin = FPlatformTime::Seconds();
+    const bool Handled = GUnrealEd->Exec(GetEditorWorld(), *Command, Outputs);
+    return JObject({
+        { "command", Command },
+        { "handled", Handled },
+        { "outputs", FString::Join(Outputs.Lines, TEXT("\n")) },
+        { "elapsed", FPlatformTime::Seconds() - Begin },
+        });
+}
+
+// /editor/exec?c=stat fps
+// /editor/exec?commands=["stat unit","r.ScreenPercentage 50"]&async=true&perTick=1
+// commands は順に実行し、コマンドごとの出力と所要時間を "results" で返す
+// async=true の場合はジョブとして 1 tick あたり perTick 個ずつ実行し、結果は /job/status で確認する
+bool FHTTPLinkModule::OnEditorExec(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    FString Command;
+    TArray<FString> Commands;
+    bool Async = false;
+    int32 PerTick = 1;
+    GetQueryParams(Request, {
+        {"c", Command}, {"command", Command}, {"commands", Commands}, {"async", Async}, {"perTick", PerTick},
+        });
+
+    if (Commands.IsEmpty()) {
+        FExecOutputDevice Outputs(LogRing.Get());
+        if (!Command.IsEmpty()) {
+            GUnrealEd->Exec(GetEditorWorld(), *Command, Outputs);
+        }
+        return ServeJson(Result, { {"outputs", FString::Join(Outputs.Lines, TEXT("\n"))} });
+    }
+    if (!Command.IsEmpty()) {
+        Commands.Insert(Command, 0);
+    }
+
+    if (Async) {
+        struct FState
+        {
+            TArray<FString> Commands;
+            int32 Next = 0;
+            JArray Results;
+        };
+        auto State = MakeShared<FState>();
+        State->Commands = MoveTemp(Commands);
+        State->Results.Reserve(State->Commands.Num());
+        PerTick = FMath::Max(PerTick, 1);
+
+        auto Job = StartJob(TEXT("editor/exec"), [this, State, PerTick](FJob& Job) {
+            const int32 Num = State->Commands.Num();
+            for (int32 I = 0; I < PerTick && State->Next < Num; ++I) {
+                State->Results.Add(ExecCommand(LogRing.Get(), State->Commands[State->Next++]));
+            }
+            Job.Progress = (float)State->Next / Num;
+            if (State->Next < Num) {
+                return false;
+            }
+            Job.Result = JObject({
+                { "result", true },
+                { "results", MoveTemp(State->Results) },
+                });
+            return true;
+            });
+        return ServeJson(Result, MakeJobStarted(Job->Id));
+    }
+
+    // 全て同じ tick で実行する
+    JArray Results;
+    Results.Reserve(Commands.Num());
+    for (auto& C : Commands) {
+        Results.Add(ExecCommand(LogRing.Get(), C));
+    }
+    return ServeJson(Result, {
+        { "result", true },
+        { "results", MoveTemp(Results) },
+        });
+}
+
+// /log/tail?cursor=1234&max=1000&wait=10
+// cursor は前回の応答の "cursor"。省略時は現在の末尾からで、以降に出力された行だけを返す (cursor=0 なら残っている全て)
+// wait を指定すると、新しい行が出るまで最大その秒数応答を保留する
+// 読み出しが追いつかず上書きされた行の数は "dropped" に入る
+bool FHTTPLinkModule::OnLogTail(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    int64 Cursor = -1;
+    int32 MaxRecords = 1000;
+    double Wait = 0.0;
+    GetQueryParams(Request, {
+        { "cursor", Cursor }, { "max", MaxRecords }, { "wait", Wait },
+        });
+
+    auto Tail = MakeShared<FLogTail>();
+    Tail->Cursor = Cursor < 0 ? LogRing->GetHead() : (uint64)Cursor;
+    Tail->MaxRecords = FMath::Clamp(MaxRecords, 1, 10000);
+    Tail->Deadline = FPlatformTime::Seconds() + FMath::Clamp(Wait, 0.0, 60.0);
+    Tail->Result = Result;
+    if (Wait <= 0.0 || LogRing->GetHead() > Tail->Cursor) {
+        return ServeLogTail(*Tail);
+    }
+    LogTails.Add(Tail);
+    return true;
+}
+
+bool FHTTPLinkModule::ServeLogTail(FLogTail& Tail)
+{
+    TArray<FLogRing::FRecord> Records;
+    uint64 Dropped = 0;
+    const uint64 Next = LogRing->Read(Tail.Cursor, Tail.MaxRecords, Records, Dropped);
+
+    JArray Lines;
+    Lines.Reserve(Records.Num());
+    for (auto& R : Records) {
+        Lines.Add(JObject({
+            { "time", R.Time },
+            { "verbosity", ToString(R.Verbosity) },
+            { "category", R.Category.ToString() },
+            { "text", MoveTemp(R.Text) },
+            }));
+    }
+    return ServeJson(Tail.Result, {
+        { "cursor", (int64)Next },
+        { "dropped", (int64)Dropped },
+        { "lines", MoveTemp(Lines) },
+        });
+}
+
+void FHTTPLinkModule::TickLogTails()
+{
+    if (LogTails.IsEmpty()) {
+        return;
+    }
+    const uint64 Head = LogRing->GetHead();
+    const double Now = FPlatformTime::Seconds();
+    for (int32 I = 0; I < LogTails.Num();) {
+        auto& Tail = *LogTails[I];
+        if (Head > Tail.Cursor || Now >= Tail.Deadline) {
+            ServeLogTail(Tail);
+            LogTails.RemoveAt(I);
+        }
+        else {
+            ++I;
+        }
+    }
+}
+
+bool FHTTPLinkModule::OnEditorScreenshot(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    static const FString ScreenshotDir = FPaths::ProjectIntermediateDir();
+    static const FString ScreenshotPath = ScreenshotDir + TEXT("screenshot.png");
+
+    auto& FS = IPlatformFile::GetPlatformPhysical();
+    auto Timestamp = FS.GetTimeStampLocal(*ScreenshotPath);
+    if (Timestamp == FDateTime::MinValue()) {
+        if (!FS.CreateDirectoryTree(*ScreenshotDir)) {
+            return Serve(Result);
+        }
+    }
+
+    double TimeGap = (FDateTime::Now() - Timestamp).GetTotalSeconds();
+    if (TimeGap < 5.0) {
+        // 5 秒以内に撮影されたスクリーンショットならそれを返す
+        return ServeFile(Result, ScreenshotPath, "image/png");
+    }
+    else {
+        if (!bScreenshotInProgress) {
+            if (!HScreenshot.IsValid()) {
+                HScreenshot = FScreenshotRequest::OnScreenshotRequestProcessed().AddRaw(this, &FHTTPLinkModule::OnScreenshotProcessed);
+            }
+
+            bool ShowUI = true;
+            GetQueryParams(Request, { {"ui", ShowUI} });
+            // 撮影リクエスト発行
+            FScreenshotRequest::RequestScreenshot(ScreenshotPath, ShowUI, false);
+            bScreenshotInProgress = true;
+
+            // エディタがアクティブなウィンドウでないと撮影処理が進まないっぽいので…
+            MakeEditorWindowForeground();
+            GEditor->RedrawLevelEditingViewports();
+        }
+
+        // 撮影が完了していないので Retry-After を返してリトライしてもらう
+        return ServeRetry(Result, "/editor/screenshot", 2);
+    }
+}
+
+void FHTTPLinkModule::OnScreenshotProcessed()
+{
+    bScreenshotInProgress = false;
+}
+#pragma endregion Editor Commands
+
+
+#pragma region Viewport Commands
+// 外部のカメラコントローラーとの間でレベルビューポートのカメラをやり取りする
+// HTTPServer モジュールは WebSocket / SSE のようなストリーミング応答を持たないので、
+// 読み出しは long-poll (前回以降に記録されたフレームをまとめて返す)、書き込みは POST で行う
+// 書き込まれた姿勢はその場では適用せず、Tick で 1 フレームに 1 回、直前の姿勢から補間しながら適用する
+
+// バイナリ形式の 1 フレーム (little endian, 56 bytes)
+struct FCameraPoseRecord
+{
+    uint64 Seq = 0;
+    double Time = 0.0;      // エディタ起動からの秒数
+    double Location[3] = {};
+    float Rotation[3] = {}; // pitch, yaw, roll (度)
+    float Fov = 90.0f;
+
+    FVector GetLocation() const { return FVector(Location[0], Location[1], Location[2]); }
+    FRotator GetRotation() const { return FRotator(Rotation[0], Rotation[1], Rotation[2]); }
+
+    void SetPose(const FVector& L, const FRotator& R, float InFov)
+    {
+        Location[0] = L.X; Location[1] = L.Y; Location[2] = L.Z;
+        Rotation[0] = R.Pitch; Rotation[1] = R.Yaw; Rotation[2] = R.Roll;
+        Fov = InFov;
+    }
+
+    bool SamePose(const FCameraPoseRecord& V) const
+    {
+        return FMemory::Memcmp(Location, V.Location, sizeof(Location)) == 0
+            && FMemory::Memcmp(Rotation, V.Rotation, sizeof(Rotation)) == 0
+            && Fov == V.Fov;
+    }
+
+    JObject ToJson() const
+    {
+        return JObject({
+            { "seq", (int64)Seq },
+            { "time", Time },
+            { "location", MakeTuple(Location[0], Location[1], Location[2]) },
+            { "rotation", MakeTuple(Rotation[0], Rotation[1], Rotation[2]) },
+            { "fov", Fov },
+            });
+    }
+};
+static_assert(sizeof(FCameraPoseRecord) == 56, "FCameraPoseRecord must match the documented wire format");
+
+struct FHTTPLinkModule::FCameraChannel
+{
+    struct FWaiter
+    {
+        uint64 After = 0;
+        double Deadline = 0.0;
+        bool bBinary = true;
+        FHTTPLinkResultCallback Result;
+    };
+
+    // 読み出し側。姿勢が変わったフレームだけ記録する
+    TArray<FCameraPoseRecord> History;
+    static constexpr int32 MaxHistory = 120;
+    uint64 LastSeq = 0;
+    TArray<FWaiter> Waiters;
+
+    // 書き込み側。Start から Target へ Duration 秒かけて補間する
+    // Duration は直前の更新との間隔なので、コントローラーの送信レートに追従する
+    FCameraPoseRecord Start;
+    FCameraPoseRecord Target;
+    double StartTime = 0.0;
+    double Duration = 0.0;
+    double LastReceiveTime = 0.0;
+    bool bDriving = false;
+    static constexpr double MaxInterpolation = 0.1;
+
+    // After より後に記録されたフレーム
+    TArrayView<const FCameraPoseRecord> Since(uint64 After) const
+    {
+        int32 First = History.Num();
+        while (First > 0 && History[First - 1].Seq > After) {
+            --First;
+        }
+        return TArrayView<const FCameraPoseRecord>(History.GetData() + First, History.Num() - First);
+    }
+
+    // 前回の記録から姿勢が変わっていれば記録する
+    void Record(FLevelEditorViewportClient* Client, double Now)
+    {
+        FCameraPoseRecord R;
+        R.Time = Now - GStartTime;
+        R.SetPose(Client->GetViewLocation(), Client->GetViewRotation(), Client->ViewFOV);
+        if (History.Num() && History.Last().SamePose(R)) {
+            return;
+        }
+        R.Seq = ++LastSeq;
+        if (History.Num() >= MaxHistory) {
+            History.RemoveAt(0, History.Num() - MaxHistory + 1, false);
+        }
+        History.Add(R);
+    }
+};
+
+FHTTPLinkModule::FCameraChannel& FHTTPLinkModule::GetCameraChannel()
+{
+    if (!CameraChannel) {
+        CameraChannel = MakeShared<FCameraChannel>();
+    }
+    return *CameraChannel;
+}
+
+static FLevelEditorViewportClient* GetCameraViewportClient()
+{
+    FLevelEditorViewportClient* Client = GCurrentLevelEditingViewportClient;
+    return Client && Client->IsPerspective() ? Client : nullptr;
+}
+
+static bool ServeCameraFrames(const FHTTPLinkResultCallback& Result, TArrayView<const FCameraPoseRecord> Frames, uint64 LastSeq, bool Binary)
+{
+    if (Binary) {
+        FHTTPLinkResponse Response;
+        Response.ContentType = "application/octet-stream";
+        Response.Body.Append((const uint8*)Frames.GetData(), Frames.Num() * sizeof(FCameraPoseRecord));
+        Response.Headers.Add(TEXT("X-HTTPLink-Camera-Seq"), { FString::Printf(TEXT("%llu"), LastSeq) });
+        Result(MoveTemp(Response));
+        return true;
+    }
+
+    JArray Json;
+    Json.Reserve(Frames.Num());
+    for (auto& F : Frames) {
+        Json.Add(F.ToJson());
+    }
+    return ServeJson(Result, {
+        { "seq", (int64)LastSeq },
+        { "frames", MoveTemp(Json) },
+        });
+}
+
+// /viewport/camera?after=1234&wait=1&format=binary
+// after より後のフレーム (カメラが動いたフレーム) を返す。まだなければ wait 秒まで待つ
+// after を省略した場合は最新の 1 フレームをすぐに返す
+// format=binary (既定) なら FCameraPoseRecord を並べたもの、format=json なら { seq, frames }
+bool FHTTPLinkModule::OnViewportCamera(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    int64 After = -1;
+    double Wait = 1.0;
+    FString Format;
+    GetQueryParams(Request, {
+        { "after", After }, { "wait", Wait }, { "format", Format },
+        });
+    const bool Binary = Format != TEXT("json");
+
+    auto& Channel = GetCameraChannel();
+    FLevelEditorViewportClient* Client = GetCameraViewportClient();
+    if (Channel.History.IsEmpty() && Client) {
+        // 最初の呼び出し。Tick を待たずに現在の姿勢を記録しておく
+        Channel.Record(Client, FPlatformTime::Seconds());
+    }
+    if (After < 0) {
+        TArrayView<const FCameraPoseRecord> Latest;
+        if (Channel.History.Num()) {
+            Latest = TArrayView<const FCameraPoseRecord>(&Channel.History.Last(), 1);
+        }
+        return ServeCameraFrames(Result, Latest, Channel.LastSeq, Binary);
+    }
+
+    auto Frames = Channel.Since((uint64)After);
+    if (Frames.Num() || Wait <= 0.0) {
+        return ServeCameraFrames(Result, Frames, Channel.LastSeq, Binary);
+    }
+    Channel.Waiters.Add({ (uint64)After, FPlatformTime::Seconds() + FMath::Min(Wait, 30.0), Binary, Result });
+    return true;
+}
+
+// /viewport/camera/set
+// ボディが application/octet-stream なら FCameraPoseRecord (複数ある場合は最後のもの。seq と time は無視)
+// それ以外は location=x,y,z&rotation=pitch,yaw,roll&fov=90 (省略したものは現在の値のまま)
+// interp=false の場合は補間せずに次の Tick でそのまま適用する
+bool FHTTPLinkModule::OnViewportCameraSet(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    FLevelEditorViewportClient* Client = GetCameraViewportClient();
+    if (!Client) {
+        return ServeJson(Result, false);
+    }
+    auto& Channel = GetCameraChannel();
+
+    // 補間の始点は今ビューポートに出ている姿勢
+    FCameraPoseRecord Current;
+    Current.SetPose(Client->GetViewLocation(), Client->GetViewRotation(), Client->ViewFOV);
+
+    FCameraPoseRecord Target = Current;
+    bool Interp = true;
+    if (Request.ContentType.StartsWith(TEXT("application/octet-stream"))) {
+        const int64 Num = Request.Body.Num() / (int64)sizeof(FCameraPoseRecord);
+        if (Num == 0) {
+            return ServeJson(Result, false);
+        }
+        FMemory::Memcpy(&Target, Request.Body.GetData() + (Num - 1) * sizeof(FCameraPoseRecord), sizeof(FCameraPoseRecord));
+        GetQueryParams(Request, { { "interp", Interp } });
+    }
+    else {
+        FVector Location = Current.GetLocation();
+        FVector Rotation(Current.Rotation[0], Current.Rotation[1], Current.Rotation[2]);
+        double Fov = Current.Fov;
+        GetQueryParams(Request, {
+            { "location", Location }, { "rotation", Rotation }, { "fov", Fov }, { "interp", Interp },
+            });
+        Target.SetPose(Location, FRotator(Rotation.X, Rotation.Y, Rotation.Z), (float)Fov);
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    Channel.Start = Current;
+    Channel.Target = Target;
+    Channel.StartTime = Now;
+    Channel.Duration = Interp && Channel.LastReceiveTime > 0.0 ? FMath::Min(Now - Channel.LastReceiveTime, FCameraChannel::MaxInterpolation) : 0.0;
+    Channel.LastReceiveTime = Now;
+    Channel.bDriving = true;
+    return ServeJson(Result, true);
+}
+
+void FHTTPLinkModule::TickCamera()
+{
+    if (!CameraChannel) {
+        return;
+    }
+    auto& Channel = *CameraChannel;
+    const double Now = FPlatformTime::Seconds();
+
+    FLevelEditorViewportClient* Client = GetCameraViewportClient();
+    if (Client) {
+        // 書き込まれた姿勢の適用
+        if (Channel.bDriving) {
+            const double Alpha = Channel.Duration > 0.0 ? FMath::Clamp((Now - Channel.StartTime) / Channel.Duration, 0.0, 1.0) : 1.0;
+            const FVector Location = FMath::Lerp(Channel.Start.GetLocation(), Channel.Target.GetLocation(), Alpha);
+            const FRotator Rotation = FQuat::Slerp(Channel.Start.GetRotation().Quaternion(), Channel.Target.GetRotation().Quaternion(), Alpha).Rotator();
+            Client->SetViewLocation(Location);
+            Client->SetViewRotation(Rotation);
+            Client->ViewFOV = FMath::Lerp(Channel.Start.Fov, Channel.Target.Fov, (float)Alpha);
+            Client->Invalidate();
+            if (Alpha >= 1.0) {
+                // 到達したらマウスなどでの操作に戻す
+                Channel.bDriving = false;
+            }
+        }
+
+        Channel.Record(Client, Now);
+    }
+
+    for (int32 I = 0; I < Channel.Waiters.Num();) {
+        auto& W = Channel.Waiters[I];
+        auto Frames = Channel.Since(W.After);
+        if (Frames.Num() || Now >= W.Deadline) {
+            ServeCameraFrames(W.Result, Frames, Channel.LastSeq, W.bBinary);
+            Channel.Waiters.RemoveAt(I);
+        }
+        else {
+            ++I;
+        }
+    }
+}
+#pragma endregion Viewport Commands
+
+
+#pragma region Actor Commands
+static JObject MakeActorSummary(AActor* Actor)
+{
+    if (!Actor) {
+        return {};
+    }
+
+    JObject Ret({
+        { "typeName", Actor->GetClass()->GetName() },
+        { "label", Actor->GetActorLabel() },
+        { "name", Actor->GetFName() },
+        { "guid", Actor->GetActorGuid() },
+        { "transform", Actor->GetActorTransform() },
+        });
+
+    const auto& ActorComponents = Actor->GetComponents();
+    JArray Components;
+    Components.Reserve(ActorComponents.Num());
+    for (auto& C : ActorComponents) {
+        Components.Add(JObject({
+            { "typeName", C->GetClass()->GetName() },
+            { "name", C->GetName() },
+            }));
+    }
+    Ret["components"] = MoveTemp(Components);
+    return Ret;
+}
+
+// MakeActorSummary() と同じ内容を arena 上に作る
+static FJsonArenaValue* MakeActorSummary(FJsonArenaDocument& Doc, AActor* Actor)
+{
+    const auto& ActorComponents = Actor->GetComponents();
+    FJsonArenaValue* Components = Doc.MakeArray(ActorComponents.Num());
+    for (auto& C : ActorComponents) {
+        Doc.Add(Components, Doc.MakeObject({
+            { "typeName", Doc.Make(C->GetClass()->GetFName()) },
+            { "name", Doc.Make(C->GetFName()) },
+            }));
+    }
+
+    return Doc.MakeObject({
+        { "typeName", Doc.Make(Actor->GetClass()->GetFName()) },
+        { "label", Doc.Make(Actor->GetActorLabel()) },
+        { "name", Doc.Make(Actor->GetFName()) },
+        { "guid", Doc.Make(Actor->GetActorGuid()) },
+        { "transform", Doc.Make(Actor->GetActorTransform()) },
+        { "components", Components },
+        });
+}
+
+// format=compact 用。クラス名やコンポーネント名は Strings のインデックスで参照する
+// components は [typeName, name, typeName, name, ...] の平坦な配列
+static JObject MakeActorSummaryCompact(AActor* Actor, FStringTable& Strings)
+{
+    JObject Ret({
+        { "typeName", Strings.Add(Actor->GetClass()->GetFName()) },
+        { "label", Actor->GetActorLabel() },
+        { "name", Actor->GetFName() },
+        { "guid", Actor->GetActorGuid() },
+        { "transform", Actor->GetActorTransform() },
+        });
+
+    const auto& ActorComponents = Actor->GetComponents();
+    TArray<int32> Components;
+    Components.Reserve(ActorComponents.Num() * 2);
+    for (auto& C : ActorComponents) {
+        Components.Add(Strings.Add(C->GetClass()->GetFName()));
+        Components.Add(Strings.Add(C->GetFName()));
+    }
+    Ret["components"] = MoveTemp(Components);
+    return Ret;
+}
+
+// filter に使えるアクタのフィールド
+static FActorFilter::FAccessor ResolveActorFilterField(const FString& Name)
+{
+    using FV = FFilterValue;
+    static const TMap<FString, FActorFilter::FAccessor> Fields = {
+        { TEXT("class"), [](AActor* const& A, FV& V) { V.SetString(A->GetClass()->GetName()); } },
+        { TEXT("label"), [](AActor* const& A, FV& V) { V.SetString(A->GetActorLabel()); } },
+        { TEXT("name"), [](AActor* const& A, FV& V) { V.SetString(A->GetName()); } },
+        { TEXT("guid"), [](AActor* const& A, FV& V) { V.SetString(A->GetActorGuid().ToString()); } },
+        { TEXT("folder"), [](AActor* const& A, FV& V) { V.SetString(A->GetFolderPath().ToString()); } },
+        { TEXT("tags"), [](AActor* const& A, FV& V) { V.SetString(FString::JoinBy(A->Tags, TEXT(","), [](const FName& T) { return T.ToString(); })); } },
+        { TEXT("hidden"), [](AActor* const& A, FV& V) { V.SetBool(A->IsHiddenEd()); } },
+        { TEXT("selected"), [](AActor* const& A, FV& V) { V.SetBool(A->IsSelected()); } },
+        { TEXT("attached"), [](AActor* const& A, FV& V) { V.SetBool(A->GetAttachParentActor() != nullptr); } },
+        { TEXT("location.x"), [](AActor* const& A, FV& V) { V.SetNumber(A->GetActorLocation().X); } },
+        { TEXT("location.y"), [](AActor* const& A, FV& V) { V.SetNumber(A->GetActorLocation().Y); } },
+        { TEXT("location.z"), [](AActor* const& A, FV& V) { V.SetNumber(A->GetActorLocation().Z); } },
+        { TEXT("rotation.pitch"), [](AActor* const& A, FV& V) { V.SetNumber(A->GetActorRotation().Pitch); } },
+        { TEXT("rotation.yaw"), [](AActor* const& A, FV& V) { V.SetNumber(A->GetActorRotation().Yaw); } },
+        { TEXT("rotation.roll"), [](AActor* const& A, FV& V) { V.SetNumber(A->GetActorRotation().Roll); } },
+        { TEXT("scale.x"), [](AActor* const& A, FV& V) { V.SetNumber(A->GetActorScale3D().X); } },
+        { TEXT("scale.y"), [](AActor* const& A, FV& V) { V.SetNumber(A->GetActorScale3D().Y); } },
+        { TEXT("scale.z"), [](AActor* const& A, FV& V) { V.SetNumber(A->GetActorScale3D().Z); } },
+    };
+    if (auto* Found = Fields.Find(Name)) {
+        return *Found;
+    }
+    return {};
+}
+
+// filter に使えるアセットのフィールド
+// 以下以外の名前はアセットレジストリのタグとして扱う (例: NumTriangles>10000)
+static FAssetFilter::FAccessor ResolveAssetFilterField(const FString& Name)
+{
+    using FV = FFilterValue;
+    if (Name == TEXT("class")) {
+        return [](const FAssetData& A, FV& V) {
+#if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 1
+            V.SetString(A.AssetClassPath.GetAssetName().ToString());
+#else
+            V.SetString(A.AssetClass.ToString());
+#endif
+        };
+    }
+    else if (Name == TEXT("name")) {
+        return [](const FAssetData& A, FV& V) { V.SetString(A.AssetName.ToString()); };
+    }
+    else if (Name == TEXT("package")) {
+        return [](const FAssetData& A, FV& V) { V.SetString(A.PackageName.ToString()); };
+    }
+    else if (Name == TEXT("path")) {
+        return [](const FAssetData& A, FV& V) { V.SetString(GetObectPathStr(A)); };
+    }
+
+    FName Tag(*Name);
+    return [Tag](const FAssetData& A, FV& V) {
+        FString Value;
+        if (A.GetTagValue(Tag, Value)) {
+            V.SetString(MoveTemp(Value));
+        }
+    };
+}
+
+struct FHTTPLinkModule::FQueryFilters
+{
+    TFilterCache<AActor*> Actors = TFilterCache<AActor*>(&ResolveActorFilterField);
+    TFilterCache<FAssetData> Assets = TFilterCache<FAssetData>(&ResolveAssetFilterField);
+};
+
+FHTTPLinkModule::FQueryFilters& FHTTPLinkModule::GetQueryFilters()
+{
+    if (!QueryFilters) {
+        QueryFilters = MakeShared<FQueryFilters>();
+    }
+    return *QueryFilters;
+}
+
+// Objects のうち Filter に合致するものに Body を呼ぶ。Filter が空の場合は全て
+// 評価は並列に行い、シリアライズなどの Body は呼び出し元のスレッドで順に行う
+template<class T, class Body>
+static bool EachFiltered(TFilterCache<T>& Cache, const FString& Filter, const TArray<T>& Objects, FString& OutError, Body&& F)
+{
+    if (Filter.IsEmpty()) {
+        for (const T& Obj : Objects) {
+            F(Obj);
+        }
+        return true;
+    }
+
+    auto Expr = Cache.Get(Filter, &OutError);
+    if (!Expr) {
+        return false;
+    }
+    TArray<uint8> Matches;
+    Expr->EvaluateParallel(Objects, Matches);
+    for (int32 I = 0; I < Objects.Num(); ++I) {
+        if (Matches[I]) {
+            F(Objects[I]);
+        }
+    }
+    return true;
+}
+
+// layout=columnar 用の数値カラム
+// Base64 が true の場合はリトルエンディアンのバイナリを base64 にした文字列にする (Float32Array / numpy.frombuffer でそのまま読める)
+template<class T>
+static TSharedPtr<FJsonValue> MakeNumericColumn(const TArray<T>& Values, bool Base64)
+{
+    static_assert(PLATFORM_LITTLE_ENDIAN, "columnar binary output assumes a little-endian host");
+    if (Base64) {
+        return MakeShared<FJsonValueString>(FBase64::Encode((const uint8*)Values.GetData(), Values.Num() * sizeof(T)));
+    }
+    TArray<TSharedPtr<FJsonValue>> Ret;
+    Ret.Reserve(Values.Num());
+    for (T V : Values) {
+        Ret.Add(MakeShared<FJsonValueNumber>(V));
+    }
+    return MakeShared<FJsonValueArray>(MoveTemp(Ret));
+}
+
+// layout=columnar
+// フィールドごとの配列 (structure of arrays) を返す。i 番目のアクタは各配列の i 番目の要素
+// classes は classNames のインデックス。locations / scales は xyz、rotations はクォータニオンの xyzw を平坦に並べた float32
+static JObject MakeActorColumns(const TArray<AActor*>& Actors, bool Base64)
+{
+    const int32 Num = Actors.Num();
+    TArray<FString> Guids;
+    TArray<FString> Labels;
+    TArray<int32> Classes;
+    TArray<float> Locations;
+    TArray<float> Rotations;
+    TArray<float> Scales;
+    Guids.Reserve(Num);
+    Labels.Reserve(Num);
+    Classes.Reserve(Num);
+    Locations.Reserve(Num * 3);
+    Rotations.Reserve(Num * 4);
+    Scales.Reserve(Num * 3);
+
+    FStringTable ClassNames;
+    for (AActor* Actor : Actors) {
+        const FTransform& Transform = Actor->GetActorTransform();
+        const FVector T = Transform.GetTranslation();
+        const FQuat R = Transform.GetRotation();
+        const FVector S = Transform.GetScale3D();
+
+        Guids.Add(Actor->GetActorGuid().ToString());
+        Labels.Add(Actor->GetActorLabel());
+        Classes.Add(ClassNames.Add(Actor->GetClass()->GetFName()));
+        Locations.Append({ (float)T.X, (float)T.Y, (float)T.Z });
+        Rotations.Append({ (float)R.X, (float)R.Y, (float)R.Z, (float)R.W });
+        Scales.Append({ (float)S.X, (float)S.Y, (float)S.Z });
+    }
+
+    JObject Ret({
+        { "layout", "columnar" },
+        { "encoding", Base64 ? "base64" : "json" },
+        { "count", Num },
+        { "classNames", ClassNames.ToJson() },
+        { "guids", MoveTemp(Guids) },
+        { "labels", MoveTemp(Labels) },
+        });
+    Ret.Data->SetField(TEXT("classes"), MakeNumericColumn(Classes, Base64));
+    Ret.Data->SetField(TEXT("locations"), MakeNumericColumn(Locations, Base64));
+    Ret.Data->SetField(TEXT("rotations"), MakeNumericColumn(Rotations, Base64));
+    Ret.Data->SetField(TEXT("scales"), MakeNumericColumn(Scales, Base64));
+    if (Base64) {
+        Ret["dtypes"] = JObject({
+            { "classes", "int32" },
+            { "locations", "float32" },
+            { "rotations", "float32" },
+            { "scales", "float32" },
+            });
+    }
+    return Ret;
+}
+
+// /actor/list?filter=class==StaticMeshActor && label~"Rock*"&format=compact
+// format=compact の場合、重複する文字列を共有テーブルにまとめた { format, strings, items } を返す
+// layout=columnar の場合はフィールドごとの配列を返す (MakeActorColumns 参照)。encoding=base64 で数値カラムをバイナリにする
+bool FHTTPLinkModule::OnActorList(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    FString Filter;
+    FString Format;
+    FString Layout;
+    FString Encoding;
+    GetQueryParams(Request, {
+        { "filter", Filter },
+        { "format", Format },
+        { "layout", Layout },
+        { "encoding", Encoding },
+        });
+    const bool Compact = Format == TEXT("compact");
+
+    // ラベルは初回アクセス時に生成されることがあるので、並列評価の前にここで確定させておく
+    TArray<AActor*> Actors;
+    EachActor(GetEditorWorld(), [&](AActor* Actor) {
+        Actor->GetActorLabel();
+        Actors.Add(Actor);
+        });
+
+    TArray<AActor*> Matched;
+    FString Error;
+    bool Ok = EachFiltered(GetQueryFilters().Actors, Filter, Actors, Error, [&](AActor* Actor) {
+        Matched.Add(Actor);
+        });
+    if (!Ok) {
+        return ServeJson(Result, { { "result", false }, { "error", Error } });
+    }
+
+    if (Layout == TEXT("columnar")) {
+        return ServeJson(Result, MakeActorColumns(Matched, Encoding == TEXT("base64")));
+    }
+
+    if (Compact) {
+        JArray Json;
+        FStringTable Strings;
+        for (AActor* Actor : Matched) {
+            Json.Add(MakeActorSummaryCompact(Actor, Strings));
+        }
+        return ServeJson(Result, {
+            { "format", "compact" },
+            { "strings", Strings.ToJson() },
+            { "items", MoveTemp(Json) },
+            });
+    }
+
+    // アクタ数は数十万になり得るので、通常の形式は FJsonValue を個別に確保せず arena 上に構築する
+    auto Doc = MakeShared<FJsonArenaDocument>();
+    FJsonArenaValue* Items = Doc->MakeArray(Matched.Num());
+    for (AActor* Actor : Matched) {
+        Doc->Add(Items, MakeActorSummary(*Doc, Actor));
+    }
+    Doc->SetRoot(Items);
+    return ServeJson(Result, MoveTemp(Doc));
+}
+
+// /actor/tree?guid=...&depth=n&compact=true
+// アタッチ階層の森を返す。guid か path (オブジェクトパス) を指定した場合はそのアクタ以下のサブツリーのみ
+// depth はルートからの段数の上限 (0 でルートのみ、負の場合は無制限)
+// compact=true の場合、ネストしたオブジェクトの代わりに幅優先順の並列配列 { guids, labels, parents } を返す。
+// parents は同じ配列内の親のインデックスで、ルートは -1。親は常に子より前に来る
+bool FHTTPLinkModule::OnActorTree(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    UWorld* World = GetEditorWorld();
+    FGuid Guid;
+    FString Path;
+    int Depth = -1;
+    bool Compact = false;
+    GetQueryParams(Request, {
+        { "guid", Guid }, { "path", Path }, { "depth", Depth }, { "compact", Compact },
+        });
+    if (!World) {
+        return ServeJson(Result, false);
+    }
+
+    // ワールドを走査するのは 1 回だけ。親子関係はインデックスで引く
+    AActor* PathRoot = Path.IsEmpty() ? nullptr : FindObject<AActor>(nullptr, *Path);
+    TArray<AActor*> Actors;
+    TMap<AActor*, int32> ActorToIndex;
+    int32 RootIndex = INDEX_NONE;
+    EachActor(World, [&](AActor* Actor) {
+        if ((Guid.IsValid() && Actor->GetActorGuid() == Guid) || (PathRoot && Actor == PathRoot)) {
+            RootIndex = Actors.Num();
+        }
+        ActorToIndex.Add(Actor, Actors.Num());
+        Actors.Add(Actor);
+        });
+    if ((Guid.IsValid() || !Path.IsEmpty()) && RootIndex == INDEX_NONE) {
+        return ServeJson(Result, false);
+    }
+
+    // 子のリストは CSR 形式で持つ (Children[ChildBegin[I]] ~ Children[ChildBegin[I + 1] - 1] が I の子)
+    const int32 Num = Actors.Num();
+    TArray<int32> Parents;
+    TArray<int32> ChildBegin;
+    TArray<int32> Children;
+    Parents.SetNumUninitialized(Num);
+    ChildBegin.SetNumZeroed(Num + 1);
+    for (int32 I = 0; I < Num; ++I) {
+        AActor* Parent = Actors[I]->GetAttachParentActor();
+        int32* ParentIndex = Parent ? ActorToIndex.Find(Parent) : nullptr;
+        Parents[I] = ParentIndex ? *ParentIndex : INDEX_NONE;
+        if (ParentIndex) {
+            ++ChildBegin[*ParentIndex + 1];
+        }
+    }
+    for (int32 I = 0; I < Num; ++I) {
+        ChildBegin[I + 1] += ChildBegin[I];
+    }
+    {
+        TArray<int32> Cursor(ChildBegin.GetData(), Num);
+        Children.SetNumUninitialized(ChildBegin[Num]);
+        for (int32 I = 0; I < Num; ++I) {
+            if (Parents[I] != INDEX_NONE) {
+                Children[Cursor[Parents[I]]++] = I;
+            }
+        }
+    }
+
+    TArray<int32> Roots;
+    if (RootIndex != INDEX_NONE) {
+        Roots.Add(RootIndex);
+    }
+    else {
+        for (int32 I = 0; I < Num; ++I) {
+            if (Parents[I] == INDEX_NONE) {
+                Roots.Add(I);
+            }
+        }
+    }
+
+    if (Compact) {
+        // 幅優先で並べる
+        TArray<int32> Order = Roots;
+        TArray<int32> OrderParents;
+        TArray<int32> Levels;
+        OrderParents.Init(INDEX_NONE, Roots.Num());
+        Levels.Init(0, Roots.Num());
+        for (int32 I = 0; I < Order.Num(); ++I) {
+            if (Depth >= 0 && Levels[I] >= Depth) {
+                continue;
+            }
+            const int32 A = Order[I];
+            for (int32 C = ChildBegin[A]; C < ChildBegin[A + 1]; ++C) {
+                Order.Add(Children[C]);
+                OrderParents.Add(I);
+                Levels.Add(Levels[I] + 1);
+            }
+        }
+
+        JArray Guids, Labels, ParentsJson;
+        Guids.Reserve(Order.Num());
+        Labels.Reserve(Order.Num());
+        ParentsJson.Reserve(Order.Num());
+        for (int32 I = 0; I < Order.Num(); ++I) {
+            AActor* Actor = Actors[Order[I]];
+            Guids.Add(Actor->GetActorGuid());
+            Labels.Add(Actor->GetActorLabel());
+            ParentsJson.Add(OrderParents[I]);
+        }
+        return ServeJson(Result, {
+            { "guids", MoveTemp(Guids) },
+            { "labels", MoveTemp(Labels) },
+            { "parents", MoveTemp(ParentsJson) },
+            });
+    }
+
+    auto MakeNode = [&](auto& Self, int32 Index, int32 Level) -> JObject {
+        AActor* Actor = Actors[Index];
+        JObject Ret({
+            { "typeName", Actor->GetClass()->GetName() },
+            { "label", Actor->GetActorLabel() },
+            { "guid", Actor->GetActorGuid() },
+            });
+        if (Depth < 0 || Level < Depth) {
+            JArray Json;
+            for (int32 C = ChildBegin[Index]; C < ChildBegin[Index + 1]; ++C) {
+                Json.Add(Self(Self, Children[C], Level + 1));
+            }
+            Ret["children"] = MoveTemp(Json);
+        }
+        return Ret;
+    };
+
+    JArray Json;
+    for (int32 Root : Roots) {
+        Json.Add(MakeNode(MakeNode, Root, 0));
+    }
+    return ServeJson(Result, MoveTemp(Json));
+}
+
+// GUID のリストからアクタを引く。アクタごとに FindActor() すると O(N*M) になるので 1 パスで済ませる
+// 戻り値は Guids と同じ並びで、見つからなかったものは nullptr。同じ GUID が複数回現れた場合はその全ての位置に入る
+static TArray<AActor*> FindActorsByGuid(UWorld* World, const TArray<FGuid>& Guids)
+{
+    TArray<AActor*> Ret;
+    Ret.SetNumZeroed(Guids.Num());
+    TMap<FGuid, TArray<int32, TInlineAllocator<1>>> GuidToIndices;
+    GuidToIndices.Reserve(Guids.Num());
+    for (int32 I = 0; I < Guids.Num(); ++I) {
+        GuidToIndices.FindOrAdd(Guids[I]).Add(I);
+    }
+
+    int32 NumFound = 0;
+    EachActor(World, [&](AActor* Actor) {
+        if (NumFound < GuidToIndices.Num()) {
+            if (auto* Indices = GuidToIndices.Find(Actor->GetActorGuid())) {
+                for (int32 I : *Indices) {
+                    Ret[I] = Actor;
+                }
+                ++NumFound;
+            }
+        }
+        });
+    return Ret;
+}
+
+static TFunction<AActor* ()> GetActorFinder(const FHTTPLinkRequest& Request, std::initializer_list<ParamHandler>&& Additional = {})
+{
+    auto* World = GetEditorWorld();
+    if (!World) {
+        return {};
+    }
+
+    FGuid GUID;
     FName Name;
     FString Label;
     GetQueryParams(Request, {
-        { "guid", GUID },  {"name", Name}, {"label", Label}
-        }, MoveTemp(Additional));
+        { "guid", GUID },  {"name", Name}, {"label", Label}
+        }, MoveTemp(Additional));
+
+    if (GUID.IsValid()) {
+        // GUID で 検索 (一意)
+        return [World, GUID]() { return FindActor(World, [&](AActor* A) { return A->GetActorGuid() == GUID; }); };
+    }
+    else if (!Name.IsNone()) {
+        // FName で検索 (一意)
+        return [World, Name]() { return FindActor(World, [&](AActor* A) { return A->GetFName() == Name; }); };
+    }
+    else if (!Label.IsEmpty()) {
+        // Label で検索 (一意ではない)
+        return [World, Label]() { return FindActor(World, [&](AActor* A) { return A->GetActorLabel() == Label; }); };
+    }
+    // Unique ID は変動しうるので対応しない
+    return {};
+}
+
+// /actor/select?guid=...&additive=true
+// /actor/select?guids=["...","..."] または /actor/select?filter=class==PointLight で複数を一度に選択する
+// 複数の場合は USelection のバッチ操作で囲み、選択変更の通知 (詳細パネルやアウトライナの更新) は最後の 1 回だけにする
+// deselect=true の場合は選択から外す
+bool FHTTPLinkModule::OnActorSelect(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    bool R = false;
+    bool Additive = false;
+    bool Deselect = false;
+    TArray<FGuid> Guids;
+    FString Filter;
+    TFunction<AActor* ()> Finder = GetActorFinder(Request, {
+        {"additive", Additive}, {"deselect", Deselect}, {"guids", Guids}, {"filter", Filter},
+        });
+
+    if (!Guids.IsEmpty() || !Filter.IsEmpty()) {
+        UWorld* World = GetEditorWorld();
+        if (!World) {
+            return ServeJson(Result, false);
+        }
+
+        TArray<AActor*> Targets;
+        if (!Guids.IsEmpty()) {
+            Targets = FindActorsByGuid(World, Guids);
+            Targets.Remove(nullptr);
+        }
+        else {
+            // ラベルは初回アクセス時に生成されることがあるので、並列評価の前にここで確定させておく
+            TArray<AActor*> Actors;
+            EachActor(World, [&](AActor* Actor) {
+                Actor->GetActorLabel();
+                Actors.Add(Actor);
+                });
+            FString Error;
+            bool Ok = EachFiltered(GetQueryFilters().Actors, Filter, Actors, Error, [&](AActor* Actor) {
+                Targets.Add(Actor);
+                });
+            if (!Ok) {
+                return ServeJson(Result, { { "result", false }, { "error", Error } });
+            }
+        }
+
+        USelection* Selection = GEditor->GetSelectedActors();
+        Selection->BeginBatchSelectOperation();
+        if (!Additive && !Deselect) {
+            GEditor->SelectNone(false, false, false);
+        }
+        for (AActor* Actor : Targets) {
+            GEditor->SelectActor(Actor, !Deselect, false, true);
+        }
+        Selection->EndBatchSelectOperation(false);
+        GEditor->NoteSelectionChange();
+
+        return ServeJson(Result, {
+            { "result", true },
+            { "count", Targets.Num() },
+            { "selected", Selection->Num() },
+            });
+    }
+
+    if (Finder) {
+        if (!Additive) {
+            GEditor->SelectNone(true, false);
+        }
+        if (AActor* Actor = Finder()) {
+            GEditor->SelectActor(Actor, true, true, true);
+            R = true;
+        }
+    }
+    return ServeJson(Result, R);
+}
+
+bool FHTTPLinkModule::OnActorFocus(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    bool R = false;
+    TFunction<AActor* ()> Finder = GetActorFinder(Request);
+
+    if (Finder) {
+        // アニメーションを見せるため Unreal Editor を最前面化
+        MakeEditorWindowForeground();
+
+        GEditor->SelectNone(true, false);
+        if (AActor* Actor = Finder()) {
+            GEditor->SelectActor(Actor, true, true, true);
+
+            // Actor をフォーカス (F キーと同等の操作)
+            GUnrealEd->Exec(GetEditorWorld(), TEXT("CAMERA ALIGN ACTIVEVIEWPORTONLY"));
+            R = true;
+        }
+    }
+    return ServeJson(Result, R);
+}
+
+bool FHTTPLinkModule::OnActorCreate(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    if (!GEditor) {
+        return Serve(Result);
+    }
+
+    FString Label;
+    FVector Location = FVector::Zero();
+    FString AssetPath;
+    FString ClassName; // 接辞語を除いた class 名 (例: "Actor", "StaticMeshActor", etc)
+    GetQueryParams(Request, {
+        { "label", Label }, { "location", Location }, { "assetPath", AssetPath}, { "className", ClassName}
+        });
+
+    AActor* Actor = nullptr;
+    auto SpawnActorScope = [&](auto&& SpawnActor) {
+        auto UndoScope = FScopedTransaction(LOCTEXT("OnCreateActor", "OnCreateActor"));
+        Actor = SpawnActor();
+        if (Actor && !Label.IsEmpty()) {
+            Actor->SetActorLabel(Label);
+        }
+    };
+
+    if (!AssetPath.IsEmpty()) {
+        FAssetData AssetData = GetAssetByObjectPath(AssetPath);
+        if (AssetData.IsValid()) {
+            SpawnActorScope([&]() {
+                return GetEditorActorSubsystem()->SpawnActorFromObject(AssetData.GetAsset(), Location);
+                });
+        }
+    }
+    else if (!ClassName.IsEmpty()) {
+        if (UClass* C = FEditorClassUtils::GetClassFromString(ClassName)) {
+            SpawnActorScope([&]() {
+                return GetEditorActorSubsystem()->SpawnActorFromClass(C, Location);
+                });
+        }
+    }
+
+    JObject Json;
+    Json["result"] = Actor ? true : false;
+    if (Actor) {
+        Json["actor"] = MakeActorSummary(Actor);
+    }
+    return ServeJson(Result, MoveTemp(Json));
+}
+
+bool FHTTPLinkModule::OnActorDelete(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    bool R = false;
+    TFunction<AActor* ()> Finder = GetActorFinder(Request);
+
+    if (Finder) {
+        if (AActor* Actor = Finder()) {
+            auto UndoScope = FScopedTransaction(LOCTEXT("OnDeleteActor", "OnDeleteActor"));
+            Actor->Modify();
+            Actor->Destroy();
+            R = true;
+        }
+    }
+    return ServeJson(Result, R);
+}
+
+bool FHTTPLinkModule::OnActorMerge(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    // todo
+    return ServeJson(Result, false);
+}
+
+// 指定された要素のみ置き換え、もしくは (Absolute == false なら) 現在の transform に合成する
+static FTransform ComposeTransform(const FTransform& Current, const FVector* Translation, const FQuat* Rotation, const FVector* Scale, bool Absolute)
+{
+    FTransform Ret = Current;
+    if (Scale) {
+        Ret.SetScale3D(Absolute ? *Scale : Current.GetScale3D() * *Scale);
+    }
+    if (Rotation) {
+        Ret.SetRotation(Absolute ? *Rotation : Current.GetRotation() * *Rotation);
+    }
+    if (Translation) {
+        Ret.SetTranslation(Absolute ? *Translation : Current.GetTranslation() + *Translation);
+    }
+    return Ret;
+}
+
+// session=<id> を指定した場合は編集セッションの undo に記録される。それ以外では undo には記録しない
+bool FHTTPLinkModule::OnActorTransform(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    FEditSession* Session;
+    if (!ResolveEditSession(Request, Session)) {
+        return ServeInvalidSession(Result);
+    }
+
+    bool R = false;
+    AActor* Target = nullptr;
+    if (auto Finder = GetActorFinder(Request)) {
+        Target = Finder();
+    }
+    if (Target) {
+        FVector Translation;
+        FQuat Rotation;
+        FVector Scale;
+        bool Absolute = true;
+        auto Set = GetQueryParams(Request, {
+            { "t", Translation }, { "r", Rotation }, { "s", Scale}, { "abs", Absolute},
+            });
+
+        bool HasT = Set.Contains("t"), HasR = Set.Contains("r"), HasS = Set.Contains("s");
+        // 正規化されていないクォータニオンはスケールや歪みとして transform に混ざるので、適用前に正規化する
+        if (HasR) {
+            Rotation.Normalize();
+        }
+        if (HasT || HasR || HasS) {
+            if (Session) {
+                FEditSession::Modify(Session, Target);
+            }
+            // SetActorLocation/Rotation/Scale3D を個別に呼ぶと都度子コンポーネントの transform 更新が走るので、1 回にまとめる
+            Target->SetActorTransform(ComposeTransform(Target->GetActorTransform(),
+                HasT ? &Translation : nullptr, HasR ? &Rotation : nullptr, HasS ? &Scale : nullptr, Absolute));
+            GEngine->BroadcastOnActorMoved(Target);
+            R = true;
+        }
+    }
+    return ServeJson(Result, R);
+}
+
+// 複数アクタの transform を一括で更新
+// ボディ (もしくは json パラメータ) に以下の形式で渡す:
+//   { "items": [ [guid, tx, ty, tz, qx, qy, qz, qw, sx, sy, sz, relative], ... ] }
+// relative が 0 以外の場合、現在の transform に合成する (t は加算, r と s は乗算)
+// 形式が正しくない要素は適用せず、インデックスと理由を invalid に返す (その場合 result は false)
+bool FHTTPLinkModule::OnActorTransforms(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    UWorld* World = GetEditorWorld();
+    JObject Args;
+    if (!World || !GetJsonArgs(Request, Args)) {
+        return ServeJson(Result, false);
+    }
+    FEditSession* Session;
+    if (!ResolveEditSession(Request, Session)) {
+        return ServeInvalidSession(Result);
+    }
+
+    struct FItem
+    {
+        FGuid Guid;
+        FTransform Transform;
+        bool Relative = false;
+        AActor* Actor = nullptr;
+    };
+
+    // AsNumber() / AsString() は型が違うと黙って 0 や空文字列を返すので、要素ごとに型を確かめる
+    auto ParseItem = [](const TSharedPtr<FJsonValue>& V, FItem& Dst, FString& OutError) {
+        const TArray<TSharedPtr<FJsonValue>>* E;
+        if (!V->TryGetArray(E) || E->Num() < 12) {
+            OutError = TEXT("item must be an array of 12 elements");
+            return false;
+        }
+        FString GuidStr;
+        if (!(*E)[0]->TryGetString(GuidStr) || !FGuid::Parse(GuidStr, Dst.Guid)) {
+            OutError = TEXT("element 0 must be a guid");
+            return false;
+        }
+        double N[12];
+        for (int32 I = 1; I < 12; ++I) {
+            if (!(*E)[I]->TryGetNumber(N[I]) || !FMath::IsFinite(N[I])) {
+                OutError = FString::Printf(TEXT("element %d must be a number"), I);
+                return false;
+            }
+        }
+        const FQuat Rotation(N[4], N[5], N[6], N[7]);
+        if (FMath::IsNearlyZero(Rotation.SizeSquared())) {
+            OutError = TEXT("rotation must not be a zero quaternion");
+            return false;
+        }
+        Dst.Transform = FTransform(Rotation.GetNormalized(), FVector(N[1], N[2], N[3]), FVector(N[8], N[9], N[10]));
+        Dst.Relative = N[11] != 0.0;
+        return true;
+    };
+
+    TArray<FItem> Items;
+    JArray Invalid;
+    {
+        const TArray<TSharedPtr<FJsonValue>>* Packed;
+        if (!Args.Data->TryGetArrayField(TEXT("items"), Packed)) {
+            return ServeJson(Result, false);
+        }
+        Items.Reserve(Packed->Num());
+        for (int32 Index = 0; Index < Packed->Num(); ++Index) {
+            FItem Item;
+            FString Error;
+            if (!ParseItem((*Packed)[Index], Item, Error)) {
+                Invalid.Add(JObject({
+                    { "index", Index },
+                    { "error", Error },
+                    }));
+                continue;
+            }
+            Items.Add(Item);
+        }
+    }
+
+    {
+        TArray<FGuid> Guids;
+        Guids.Reserve(Items.Num());
+        for (auto& Item : Items) {
+            Guids.Add(Item.Guid);
+        }
+        TArray<AActor*> Actors = FindActorsByGuid(World, Guids);
+        for (int32 I = 0; I < Items.Num(); ++I) {
+            Items[I].Actor = Actors[I];
+        }
+    }
+
+    // Undo は 1 回分にまとめる。編集セッション中はセッションのトランザクションに入る
+    // コンポーネントの render state は SetActorTransform() 内で dirty 扱いになるだけで、実際の更新はフレーム末尾に 1 回だけ行われる
+    int32 NumApplied = 0;
+    JArray Missing;
+    {
+        TOptional<FScopedTransaction> UndoScope;
+        if (!Session) {
+            UndoScope.Emplace(LOCTEXT("OnActorTransforms", "OnActorTransforms"));
+        }
+        for (auto& Item : Items) {
+            if (!Item.Actor) {
+                Missing.Add(Item.Guid);
+                continue;
+            }
+            FEditSession::Modify(Session, Item.Actor);
+            FTransform Transform = Item.Transform;
+            if (Item.Relative) {
+                FVector T = Transform.GetTranslation(), S = Transform.GetScale3D();
+                FQuat R = Transform.GetRotation();
+                Transform = ComposeTransform(Item.Actor->GetActorTransform(), &T, &R, &S, false);
+            }
+            Item.Actor->SetActorTransform(Transform);
+            GEngine->BroadcastOnActorMoved(Item.Actor);
+            ++NumApplied;
+        }
+    }
+    GEditor->RedrawLevelEditingViewports();
+
+    return ServeJson(Result, {
+        { "result", NumApplied > 0 && Invalid.Num() == 0 },
+        { "applied", NumApplied },
+        { "missing", Missing },
+        { "invalid", Invalid },
+        });
+}
+
+
+// アクタのワールドバウンディングボックスの BVH
+// 初回のクエリで構築し、以降はアクタの追加/削除/移動のイベントで差分更新する。
+// マップの切り替えや Undo/Redo の後は次のクエリで作り直す。
+struct FHTTPLinkModule::FActorSpatialIndex
+{
+    struct FEntry
+    {
+        TWeakObjectPtr<AActor> Actor;
+        FBox Bounds;
+    };
+
+    TDynamicBVH<FEntry> BVH = TDynamicBVH<FEntry>(50.0);
+    TMap<AActor*, int32> Proxies;
+    TWeakObjectPtr<UWorld> World;
+    bool bDirty = true;
+
+    FDelegateHandle HActorAdded;
+    FDelegateHandle HActorDeleted;
+    FDelegateHandle HActorMoved;
+    FDelegateHandle HMapChange;
+    FDelegateHandle HUndoRedo;
+
+    FActorSpatialIndex()
+    {
+        HActorAdded = GEngine->OnLevelActorAdded().AddLambda([this](AActor* Actor) { Add(Actor); });
+        HActorDeleted = GEngine->OnLevelActorDeleted().AddLambda([this](AActor* Actor) { Remove(Actor); });
+        HActorMoved = GEngine->OnActorMoved().AddLambda([this](AActor* Actor) { Update(Actor); });
+        HMapChange = FEditorDelegates::MapChange.AddLambda([this](uint32) { bDirty = true; });
+        HUndoRedo = FEditorDelegates::PostUndoRedo.AddLambda([this]() { bDirty = true; });
+    }
+
+    ~FActorSpatialIndex()
+    {
+        if (GEngine) {
+            GEngine->OnLevelActorAdded().Remove(HActorAdded);
+            GEngine->OnLevelActorDeleted().Remove(HActorDeleted);
+            GEngine->OnActorMoved().Remove(HActorMoved);
+        }
+        FEditorDelegates::MapChange.Remove(HMapChange);
+        FEditorDelegates::PostUndoRedo.Remove(HUndoRedo);
+    }
+
+    static FBox GetBounds(AActor* Actor)
+    {
+        FBox Box = Actor->GetComponentsBoundingBox(true);
+        if (!Box.IsValid) {
+            // 形状を持たないアクタは位置のみ
+            Box = FBox(Actor->GetActorLocation(), Actor->GetActorLocation());
+        }
+        return Box;
+    }
+
+    void Add(AActor* Actor)
+    {
+        if (!bDirty && Actor && Actor->GetWorld() == World.Get() && !Proxies.Contains(Actor)) {
+            FBox Bounds = GetBounds(Actor);
+            Proxies.Add(Actor, BVH.Insert(Bounds, FEntry{ Actor, Bounds }));
+        }
+    }
+
+    void Remove(AActor* Actor)
+    {
+        int32 Id;
+        if (Proxies.RemoveAndCopyValue(Actor, Id)) {
+            BVH.Remove(Id);
+        }
+    }
+
+    void Update(AActor* Actor)
+    {
+        if (bDirty || !Actor) {
+            return;
+        }
+        // アタッチされている子も一緒に動いている
+        TArray<AActor*> Actors;
+        Actor->GetAttachedActors(Actors, true, true);
+        Actors.Add(Actor);
+        for (AActor* A : Actors) {
+            if (int32* Id = Proxies.Find(A)) {
+                FBox Bounds = GetBounds(A);
+                BVH.GetData(*Id).Bounds = Bounds;
+                BVH.Update(*Id, Bounds);
+            }
+            else {
+                Add(A);
+            }
+        }
+    }
+
+    // 必要であれば作り直す
+    void Validate()
+    {
+        UWorld* Current = GetEditorWorld();
+        if (!bDirty && World.Get() == Current) {
+            return;
+        }
+        BVH.Clear();
+        Proxies.Reset();
+        World = Current;
+        bDirty = false;
+        EachActor(Current, [&](AActor* Actor) { Add(Actor); });
+    }
+
+    template<class Overlap, class Visit>
+    void Query(Overlap&& Test, Visit&& F)
+    {
+        BVH.Query(Test, [&](int32 Id) {
+            auto& Entry = BVH.GetData(Id);
+            if (Test(Entry.Bounds)) {
+                if (AActor* Actor = Entry.Actor.Get()) {
+                    F(Actor, Entry.Bounds);
+                }
+            }
+            return true;
+            });
+    }
+};
+
+FHTTPLinkModule::FActorSpatialIndex& FHTTPLinkModule::GetSpatialIndex()
+{
+    if (!SpatialIndex) {
+        SpatialIndex = MakeShared<FActorSpatialIndex>();
+    }
+    SpatialIndex->Validate();
+    return *SpatialIndex;
+}
+
+static JObject MakeQueryHit(AActor* Actor, bool Summary)
+{
+    if (Summary) {
+        return MakeActorSummary(Actor);
+    }
+    return JObject({
+        { "guid", Actor->GetActorGuid() },
+        { "label", Actor->GetActorLabel() },
+        });
+}
+
+// /actor/query/box?min=x,y,z&max=x,y,z
+bool FHTTPLinkModule::OnActorQueryBox(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    FVector Min, Max;
+    bool Summary = false;
+    auto Set = GetQueryParams(Request, {
+        { "min", Min }, { "max", Max }, { "summary", Summary },
+        });
+    if (!GEditor || !Set.Contains("min") || !Set.Contains("max")) {
+        return ServeJson(Result, false);
+    }
+
+    const FBox Box(Min, Max);
+    JArray Json;
+    GetSpatialIndex().Query(
+        [&](const FBox& B) { return B.Intersect(Box); },
+        [&](AActor* Actor, const FBox&) { Json.Add(MakeQueryHit(Actor, Summary)); });
+    return ServeJson(Result, MoveTemp(Json));
+}
+
+// /actor/query/sphere?center=x,y,z&radius=r
+bool FHTTPLinkModule::OnActorQuerySphere(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    FVector Center;
+    double Radius = 0.0;
+    bool Summary = false;
+    auto Set = GetQueryParams(Request, {
+        { "center", Center }, { "radius", Radius }, { "summary", Summary },
+        });
+    if (!GEditor || !Set.Contains("center")) {
+        return ServeJson(Result, false);
+    }
+
+    const double RadiusSq = Radius * Radius;
+    JArray Json;
+    GetSpatialIndex().Query(
+        [&](const FBox& B) { return B.ComputeSquaredDistanceToPoint(Center) <= RadiusSq; },
+        [&](AActor* Actor, const FBox&) { Json.Add(MakeQueryHit(Actor, Summary)); });
+    return ServeJson(Result, MoveTemp(Json));
+}
+
+// /actor/query/ray?origin=x,y,z&dir=x,y,z&length=l
+// バウンディングボックスとの交差判定のみ。近い順に返す
+bool FHTTPLinkModule::OnActorQueryRay(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    FVector Origin, Dir;
+    double Length = TNumericLimits<double>::Max();
+    bool Summary = false;
+    auto Set = GetQueryParams(Request, {
+        { "origin", Origin }, { "dir", Dir }, { "length", Length }, { "summary", Summary },
+        });
+    if (!GEditor || !Set.Contains("origin") || !Set.Contains("dir") || !Dir.Normalize()) {
+        return ServeJson(Result, false);
+    }
+
+    using FBVH = decltype(FActorSpatialIndex::BVH);
+    const FVector InvDir = FBVH::InverseDir(Dir);
+    TArray<TPair<AActor*, double>> Hits;
+    GetSpatialIndex().Query(
+        [&](const FBox& B) { return FBVH::RayBox(Origin, InvDir, Length, B) >= 0.0; },
+        [&](AActor* Actor, const FBox& Bounds) { Hits.Emplace(Actor, FBVH::RayBox(Origin, InvDir, Length, Bounds)); });
+    Hits.Sort([](auto& A, auto& B) { return A.Value < B.Value; });
+
+    JArray Json;
+    for (auto& Hit : Hits) {
+        JObject E = MakeQueryHit(Hit.Key, Summary);
+        E["distance"] = Hit.Value;
+        Json.Add(MoveTemp(E));
+    }
+    return ServeJson(Result, MoveTemp(Json));
+}
+
+// /actor/query/nearest?point=x,y,z&count=n
+// バウンディングボックスまでの距離で近い順に n 個返す
+bool FHTTPLinkModule::OnActorQueryNearest(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    FVector Point;
+    int Count = 1;
+    bool Summary = false;
+    auto Set = GetQueryParams(Request, {
+        { "point", Point }, { "count", Count }, { "summary", Summary },
+        });
+    if (!GEditor || !Set.Contains("point")) {
+        return ServeJson(Result, false);
+    }
+
+    auto& Index = GetSpatialIndex();
+    TArray<TPair<int32, double>> Nearest;
+    Index.BVH.Nearest(Point, Count, [&](int32 Id) { return Index.BVH.GetData(Id).Bounds.ComputeSquaredDistanceToPoint(Point); }, Nearest);
+
+    JArray Json;
+    for (auto& N : Nearest) {
+        if (AActor* Actor = Index.BVH.GetData(N.Key).Actor.Get()) {
+            JObject E = MakeQueryHit(Actor, Summary);
+            E["distance"] = FMath::Sqrt(N.Value);
+            Json.Add(MoveTemp(E));
+        }
+    }
+    return ServeJson(Result, MoveTemp(Json));
+}
+
+static UActorComponent* FindComponentByName(AActor* Actor, FName Name)
+{
+    for (UActorComponent* Component : Actor->GetComponents()) {
+        if (Component && Component->GetFName() == Name) {
+            return Component;
+        }
+    }
+    return nullptr;
+}
+
+// プロパティパス ("LightComponent.Intensity" など) の解決結果のキャッシュ
+// パスごと、ルートのクラスごとに FProperty とオフセットの列を保持する。
+// オブジェクト参照をまたぐ場合は参照先の実際のクラスも記録しておき、一致する場合のみキャッシュを使う。
+// FProperty は Blueprint の再コンパイルなどで無効になりうるので、GC の後に破棄する。
+struct FHTTPLinkModule::FPropertyPathCache
+{
+    struct FStep
+    {
+        // このステップを解決したオブジェクトのクラス
+        const UClass* Class = nullptr;
+        // 最後のステップ以外はオブジェクト参照。null の場合は ComponentName のコンポーネントを辿る
+        const FProperty* Property = nullptr;
+        FName ComponentName;
+        // オブジェクト先頭からのオフセット (構造体のメンバは展開済み)
+        int32 Offset = 0;
+        // 最後のステップのみ。値を持つオブジェクトのメンバから Property までのプロパティ (RelativeLocation.X なら RelativeLocation, X)
+        TArray<const FProperty*> MemberChain;
+    };
+    using FChain = TArray<FStep>;
+
+    struct FEntry
+    {
+        FString Path;
+        TMap<const UClass*, FChain> Chains;
+
+        // 値へのポインタを返す。OutOwner は値を持つ UObject (アクタかコンポーネント)
+        // OutMemberChain は OutOwner のメンバから OutProperty までのプロパティで、次の Get() まで有効
+        void* Resolve(UObject* Root, UObject*& OutOwner, const FProperty*& OutProperty, const TArray<const FProperty*>** OutMemberChain = nullptr)
+        {
+            if (FChain* Chain = Chains.Find(Root->GetClass())) {
+                if (void* Ret = Walk(Root, *Chain, OutOwner, OutProperty, OutMemberChain)) {
+                    return Ret;
+                }
+            }
+            // 失敗はデータ (null の参照など) に依存しうるのでキャッシュしない
+            FChain Chain;
+            if (!Build(Root, Path, Chain)) {
+                return nullptr;
+            }
+            return Walk(Root, Chains.Add(Root->GetClass(), MoveTemp(Chain)), OutOwner, OutProperty, OutMemberChain);
+        }
+    };
+
+    TMap<FString, FEntry> Entries;
+    FDelegateHandle HPostGC;
+
+    FPropertyPathCache()
+    {
+        HPostGC = FCoreUObjectDelegates::GetPostGarbageCollect().AddLambda([this]() { Entries.Reset(); });
+    }
+
+    ~FPropertyPathCache()
+    {
+        FCoreUObjectDelegates::GetPostGarbageCollect().Remove(HPostGC);
+    }
+
+    // 返る参照は次の Get() まで有効。ハンドラはパスごとに 1 回 Get() し、アクタごとに Resolve() する
+    FEntry& Get(const FString& Path)
+    {
+        FEntry& Ret = Entries.FindOrAdd(Path);
+        Ret.Path = Path;
+        return Ret;
+    }
+
+    static bool Build(UObject* Root, const FString& Path, FChain& Dst)
+    {
+        TArray<FString> Names;
+        Path.ParseIntoArray(Names, TEXT("."));
+
+        UObject* Obj = Root;
+        const UStruct* Struct = Root->GetClass();
+        int32 Offset = 0;
+        TArray<const FProperty*> Members;
+        for (int32 I = 0; I < Names.Num(); ++I) {
+            const bool Last = I == Names.Num() - 1;
+            FStep Step;
+            Step.Class = Obj->GetClass();
+            Step.Property = FindFProperty<FProperty>(Struct, FName(*Names[I]));
+            if (!Step.Property) {
+                // UPROPERTY から参照されていないコンポーネントは名前で辿る
+                AActor* Actor = Cast<AActor>(Obj);
+                if (Last || !Actor || Struct != Step.Class) {
+                    return false;
+                }
+                Step.ComponentName = FName(*Names[I]);
+                Obj = FindComponentByName(Actor, Step.ComponentName);
+                if (!Obj) {
+                    return false;
+                }
+                Dst.Add(Step);
+                Struct = Obj->GetClass();
+                Offset = 0;
+                Members.Reset();
+                continue;
+            }
+
+            Offset += Step.Property->GetOffset_ForInternal();
+            Members.Add(Step.Property);
+            if (Last) {
+                Step.Offset = Offset;
+                Step.MemberChain = MoveTemp(Members);
+                Dst.Add(Step);
+                return true;
+            }
+            else if (auto* StructProp = CastField<FStructProperty>(Step.Property)) {
+                Struct = StructProp->Struct;
+            }
+            else if (auto* ObjProp = CastField<FObjectPropertyBase>(Step.Property)) {
+                Step.Offset = Offset;
+                Dst.Add(Step);
+                Obj = ObjProp->GetObjectPropertyValue((uint8*)Obj + Offset);
+                if (!Obj) {
+                    return false;
+                }
+                Struct = Obj->GetClass();
+                Offset = 0;
+                Members.Reset();
+            }
+            else {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    static void* Walk(UObject* Root, const FChain& Chain, UObject*& OutOwner, const FProperty*& OutProperty, const TArray<const FProperty*>** OutMemberChain)
+    {
+        UObject* Obj = Root;
+        for (int32 I = 0; I < Chain.Num(); ++I) {
+            const FStep& Step = Chain[I];
+            if (!Obj || Obj->GetClass() != Step.Class) {
+                return nullptr;
+            }
+            if (!Step.Property) {
+                Obj = FindComponentByName(CastChecked<AActor>(Obj), Step.ComponentName);
+                continue;
+            }
+            void* Ptr = (uint8*)Obj + Step.Offset;
+            if (I == Chain.Num() - 1) {
+                OutOwner = Obj;
+                OutProperty = Step.Property;
+                if (OutMemberChain) {
+                    *OutMemberChain = &Step.MemberChain;
+                }
+                return Ptr;
+            }
+            Obj = static_cast<const FObjectPropertyBase*>(Step.Property)->GetObjectPropertyValue(Ptr);
+        }
+        return nullptr;
+    }
+};
+
+FHTTPLinkModule::FPropertyPathCache& FHTTPLinkModule::GetPropertyPathCache()
+{
+    if (!PropertyPaths) {
+        PropertyPaths = MakeShared<FPropertyPathCache>();
+    }
+    return *PropertyPaths;
+}
+
+// 複数アクタの複数プロパティをまとめて取得
+//   { "guids": [...], "paths": ["LightComponent.Intensity", "bHidden", ...] }
+// 結果は [ { "guid": ..., "values": { path: value, ... } }, ... ]。解決できなかったプロパティは null
+bool FHTTPLinkModule::OnActorPropertyGet(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    UWorld* World = GetEditorWorld();
+    TArray<FGuid> Guids;
+    FGuid Guid;
+    TArray<FString> Paths;
+    FString Path;
+    GetQueryParams(Request, {
+        { "guids", Guids }, { "guid", Guid }, { "paths", Paths }, { "path", Path },
+        });
+    if (Guid.IsValid()) {
+        Guids.Add(Guid);
+    }
+    if (!Path.IsEmpty()) {
+        Paths.Add(Path);
+    }
+    if (!World || Guids.IsEmpty() || Paths.IsEmpty()) {
+        return ServeJson(Result, false);
+    }
+
+    TArray<AActor*> Actors = FindActorsByGuid(World, Guids);
+    TArray<TSharedPtr<FJsonObject>> Values;
+    Values.Reserve(Actors.Num());
+    for (int32 I = 0; I < Actors.Num(); ++I) {
+        Values.Add(MakeShared<FJsonObject>());
+    }
+
+    auto& Cache = GetPropertyPathCache();
+    for (auto& P : Paths) {
+        auto& Entry = Cache.Get(P);
+        for (int32 I = 0; I < Actors.Num(); ++I) {
+            UObject* Owner = nullptr;
+            const FProperty* Prop = nullptr;
+            void* Ptr = Actors[I] ? Entry.Resolve(Actors[I], Owner, Prop) : nullptr;
+            if (Ptr) {
+                Values[I]->SetField(P, JObject::ToJValue(Prop, Ptr));
+            }
+            else {
+                Values[I]->SetField(P, MakeShared<FJsonValueNull>());
+            }
+        }
+    }
+
+    JArray Json;
+    for (int32 I = 0; I < Actors.Num(); ++I) {
+        Json.Add(JObject({
+            { "guid", Guids[I] },
+            { "found", Actors[I] != nullptr },
+            { "values", Values[I] },
+            }));
+    }
+    return ServeJson(Result, MoveTemp(Json));
+}
+
+// 複数アクタのプロパティをまとめて設定
+// 全アクタに同じ値を設定:       { "guids": [...], "values": { "LightComponent.Intensity": 5000, ... } }
+// アクタごとに異なる値を設定:   { "items": [ { "guid": ..., "values": { ... } }, ... ] }
+// Undo は 1 回分にまとめる
+bool FHTTPLinkModule::OnActorPropertySet(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    UWorld* World = GetEditorWorld();
+    TArray<FGuid> Guids;
+    FGuid Guid;
+    TMap<FString, TSharedPtr<FJsonValue>> Values;
+    TArray<TSharedPtr<FJsonValue>> Items;
+    GetQueryParams(Request, {
+        { "guids", Guids }, { "guid", Guid }, { "values", Values }, { "items", Items },
+        });
+    if (Guid.IsValid()) {
+        Guids.Add(Guid);
+    }
+    if (!World) {
+        return ServeJson(Result, false);
+    }
+
+    // パスごとにまとめておき、パスの解決はキャッシュを引く回数を最小にする
+    TMap<FString, TArray<TPair<int32, TSharedPtr<FJsonValue>>>> Assignments;
+    for (int32 I = 0; I < Guids.Num(); ++I) {
+        for (auto& KVP : Values) {
+            Assignments.FindOrAdd(KVP.Key).Emplace(I, KVP.Value);
+        }
+    }
+    for (auto& Item : Items) {
+        TSharedPtr<FJsonObject>* Obj;
+        const TSharedPtr<FJsonObject>* ItemValues;
+        FString ItemGuid;
+        if (!Item->TryGetObject(Obj) || !(*Obj)->TryGetStringField(TEXT("guid"), ItemGuid) || !(*Obj)->TryGetObjectField(TEXT("values"), ItemValues)) {
+            continue;
+        }
+        int32 I = Guids.Add(FGuid(ItemGuid));
+        for (auto& KVP : (*ItemValues)->Values) {
+            Assignments.FindOrAdd(KVP.Key).Emplace(I, KVP.Value);
+        }
+    }
+    if (Assignments.IsEmpty()) {
+        return ServeJson(Result, false);
+    }
+    FEditSession* Session;
+    if (!ResolveEditSession(Request, Session)) {
+        return ServeInvalidSession(Result);
+    }
+
+    TArray<AActor*> Actors = FindActorsByGuid(World, Guids);
+    auto& Cache = GetPropertyPathCache();
+    int32 NumApplied = 0;
+    JArray Failed;
+    {
+        TOptional<FScopedTransaction> UndoScope;
+        if (!Session) {
+            UndoScope.Emplace(LOCTEXT("OnActorPropertySet", "OnActorPropertySet"));
+        }
+        for (auto& KVP : Assignments) {
+            auto& Entry = Cache.Get(KVP.Key);
+            for (auto& A : KVP.Value) {
+                AActor* Actor = Actors[A.Key];
+                UObject* Owner = nullptr;
+                const FProperty* Prop = nullptr;
+                const TArray<const FProperty*>* Members = nullptr;
+                if (void* Ptr = Actor ? Entry.Resolve(Actor, Owner, Prop, &Members) : nullptr) {
+                    // PostEditChangeChainProperty() でコンポーネントの再登録などが行われる
+                    // RelativeLocation.X のような構造体のメンバでも、Owner 側がメンバのプロパティ (RelativeLocation) で判断できるようにチェインで通知する
+                    FEditPropertyChain PropertyChain;
+                    for (const FProperty* Member : *Members) {
+                        PropertyChain.AddTail(const_cast<FProperty*>(Member));
+                    }
+                    FProperty* MemberProp = const_cast<FProperty*>((*Members)[0]);
+                    FProperty* MutableProp = const_cast<FProperty*>(Prop);
+                    PropertyChain.SetActiveMemberPropertyNode(MemberProp);
+                    PropertyChain.SetActivePropertyNode(MutableProp);
+
+                    FEditSession::Modify(Session, Owner);
+                    Owner->PreEditChange(PropertyChain);
+                    bool Ok = JObject::FromJValue(A.Value, Prop, Ptr);
+                    FPropertyChangedEvent Event(MutableProp, EPropertyChangeType::ValueSet);
+                    Event.SetActiveMemberProperty(MemberProp);
+                    FPropertyChangedChainEvent ChainEvent(PropertyChain, Event);
+                    Owner->PostEditChangeChainProperty(ChainEvent);
+                    if (Ok) {
+                        ++NumApplied;
+                        continue;
+                    }
+                }
+                Failed.Add(JObject({
+                    { "guid", Guids[A.Key] },
+                    { "path", KVP.Key },
+                    }));
+            }
+        }
+    }
+    GEditor->RedrawLevelEditingViewports();
+
+    return ServeJson(Result, {
+        { "result", NumApplied > 0 && Failed.Num() == 0 },
+        { "applied", NumApplied },
+        { "failed", Failed },
+        });
+}
+#pragma endregion Actor Commands
+
+
+#pragma region Level Commands
+// レベルの切り替えを行うジョブ
+// PreloadPath のパッケージを async loading (有効であれば async loading thread) で事前にロードしておき、
+// 後の tick でゲームスレッドで Switch を呼んでワールドを切り替える。
+// ロード済みのパッケージは Switch 内の LoadPackage() でそのまま使われる
+TSharedRef<FHTTPLinkModule::FJob> FHTTPLinkModule::StartLevelJob(const FString& Type, const FString& PreloadPath, TFunction<bool()>&& Switch)
+{
+    struct FState
+    {
+        FString PackageName;
+        TStrongObjectPtr<UPackage> Package;
+        bool Requested = false;
+        bool Completed = false;
+    };
+    auto State = MakeShared<FState>();
+    if (!PreloadPath.IsEmpty()) {
+        State->PackageName = FPackageName::ObjectPathToPackageName(PreloadPath);
+    }
+
+    return StartJob(Type, [State, Switch = MoveTemp(Switch)](FJob& Job) {
+        if (!State->PackageName.IsEmpty()) {
+            if (!State->Requested) {
+                State->Requested = true;
+                Job.SetPhase(TEXT("preload"), 0.0f);
+                // 完了コールバックはゲームスレッドで呼ばれる
+                LoadPackageAsync(State->PackageName, FLoadPackageAsyncDelegate::CreateLambda(
+                    [State](const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type R) {
+                        if (R == EAsyncLoadingResult::Succeeded) {
+                            State->Package.Reset(Package);
+                        }
+                        State->Completed = true;
+                    }));
+            }
+            if (!State->Completed) {
+                float Percentage = GetAsyncLoadPercentage(FName(*State->PackageName));
+                if (Percentage >= 0.0f) {
+                    Job.Progress = 0.9f * Percentage / 100.0f;
+                }
+                return false;
+            }
+            if (!State->Package) {
+                return Job.Fail(FString::Printf(TEXT("failed to load %s"), *State->PackageName));
+            }
+        }
+
+        Job.SetPhase(TEXT("switch"), 0.9f);
+        bool R = Switch();
+        State->Package.Reset();
+        Job.Result = JObject({ { "result", R } });
+        return R ? true : Job.Fail(TEXT("failed to switch level"));
+        });
+}
+
+// /level/new?assetpath=...&templatepath=...&async=true
+// async=true の場合はジョブ ID を返し、進捗は /job/status で確認する
+bool FHTTPLinkModule::OnLevelNew(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    if (!GEditor) {
+        return ServeJson(Result, false);
+    }
+
+    bool R = false;
+    bool Async = false;
+    FString AssetPath, TemplatePath;
+    GetQueryParams(Request, {
+        { "assetpath", AssetPath }, { "templatepath", TemplatePath}, { "async", Async },
+        });
+
+    if (!AssetPath.IsEmpty()) {
+        // 新しいレベルへの切り替えは undo バッファをリセットするので、編集セッションは先に確定させる
+        if (EditSession) {
+            EndEditSession(false);
+        }
+        auto NewLevel = [AssetPath, TemplatePath]() {
+            auto LevelEditorSubsystem = GEditor->GetEditorSubsystem<ULevelEditorSubsystem>();
+            if (!TemplatePath.IsEmpty()) {
+                return LevelEditorSubsystem->NewLevelFromTemplate(AssetPath, TemplatePath);
+            }
+            else {
+                return LevelEditorSubsystem->NewLevel(AssetPath);
+            }
+        };
+        if (Async) {
+            return ServeJson(Result, MakeJobStarted(StartLevelJob(TEXT("level/new"), TemplatePath, MoveTemp(NewLevel))->Id));
+        }
+        R = NewLevel();
+    }
+    return ServeJson(Result, R);
+}
+
+// /level/load?assetpath=...&async=true
+// async=true の場合はジョブ ID を返し、進捗は /job/status で確認する
+bool FHTTPLinkModule::OnLevelLoad(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    if (!GEditor) {
+        return ServeJson(Result, false);
+    }
+
+    bool R = false;
+    bool Async = false;
+    FString AssetPath;
+    GetQueryParams(Request, {
+        { "assetpath", AssetPath }, { "async", Async },
+        });
+
+    if (!AssetPath.IsEmpty()) {
+        // レベルのロードは undo バッファをリセットするので、編集セッションは先に確定させる
+        if (EditSession) {
+            EndEditSession(false);
+        }
+        auto LoadLevel = [AssetPath]() {
+            auto LevelEditorSubsystem = GEditor->GetEditorSubsystem<ULevelEditorSubsystem>();
+            return LevelEditorSubsystem->LoadLevel(AssetPath);
+        };
+        if (Async) {
+            return ServeJson(Result, MakeJobStarted(StartLevelJob(TEXT("level/load"), AssetPath, MoveTemp(LoadLevel))->Id));
+        }
+        R = LoadLevel();
+    }
+    return ServeJson(Result, R);
+}
+
+static bool GetPackageFilename(UPackage* Package, FString& OutFilename)
+{
+    const FString& Extension = Package->ContainsMap() ? FPackageName::GetMapPackageExtension() : FPackageName::GetAssetPackageExtension();
+    return FPackageName::TryConvertLongPackageNameToFilename(Package->GetName(), OutFilename, Extension);
+}
+
+// パッケージのシリアライズはゲームスレッドで行う必要があるが、SAVE_Async でファイルへの書き込みは非同期 I/O に回し、
+// 次のパッケージのシリアライズと並行して進める
+// UPackage::SavePackage() を直接呼ぶので、保存先を尋ねるダイアログもチェックアウトも行わない。
+// 名前のない (/Temp 以下の) パッケージと書き込めないファイルは保存せずにエラーにする
+static bool SavePackageAsync(UPackage* Package, FString& OutError)
+{
+    if (FPackageName::IsTempPackage(Package->GetName())) {
+        OutError = TEXT("untitled package. save it with a name from the editor first");
+        return false;
+    }
+    FString Filename;
+    if (!GetPackageFilename(Package, Filename)) {
+        OutError = TEXT("invalid package name");
+        return false;
+    }
+    if (IFileManager::Get().IsReadOnly(*Filename)) {
+        OutError = TEXT("file is read-only and could not be checked out");
+        return false;
+    }
+
+    UWorld* World = UWorld::FindWorldInPackage(Package);
+#if ENGINE_MAJOR_VERSION >= 5
+    FSavePackageArgs Args;
+    Args.TopLevelFlags = RF_Standalone;
+    Args.SaveFlags = SAVE_Async | SAVE_NoError;
+    bool R = UPackage::SavePackage(Package, World, *Filename, Args);
+#else
+    bool R = UPackage::SavePackage(Package, World, RF_Standalone, *Filename, GError, nullptr, false, true, SAVE_Async | SAVE_NoError);
+#endif
+    if (!R) {
+        OutError = TEXT("SavePackage() failed");
+    }
+    return R;
+}
+
+// World のパッケージか、World に属する外部アクタ (One File Per Actor) のパッケージか
+static bool IsPackageOfWorld(UPackage* Package, UWorld* World)
+{
+    if (UWorld::FindWorldInPackage(Package) == World) {
+        return true;
+    }
+    bool Ret = false;
+    ForEachObjectWithPackage(Package, [&](UObject* Obj) {
+        if (AActor* Actor = Cast<AActor>(Obj)) {
+            Ret = Actor->GetWorld() == World;
+        }
+        return !Ret;
+        }, false);
+    return Ret;
+}
+
+// /level/save?all=true&async=true
+// async=true の場合、ダーティなパッケージの集合をその時点で確定させ、ジョブとして数フレームにわたって保存する。
+// 進捗は /job/status で確認する
+// ソース管理が有効なら読み取り専用のファイルは開始前にチェックアウトを試みる。名前のないマップは保存しない (failed に入る)
+bool FHTTPLinkModule::OnLevelSave(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    if (!GEditor) {
+        return ServeJson(Result, false);
+    }
+
+    bool R = false;
+    bool All = false;
+    bool Async = false;
+    GetQueryParams(Request, {
+        { "all", All }, { "async", Async },
+        });
+
+    if (Async) {
+        struct FState
+        {
+            TArray<TWeakObjectPtr<UPackage>> Packages;
+            int32 Next = 0;
+            int32 NumSaved = 0;
+            bool Flushing = false;
+            JArray Failed;
+        };
+        auto State = MakeShared<FState>();
+
+        UWorld* World = GetEditorWorld();
+        TArray<UPackage*> Dirty;
+        TArray<UPackage*> ReadOnly;
+        FEditorFileUtils::GetDirtyWorldPackages(Dirty);
+        for (UPackage* Package : Dirty) {
+            if (All || IsPackageOfWorld(Package, World)) {
+                State->Packages.Add(Package);
+                FString Filename;
+                if (GetPackageFilename(Package, Filename) && IFileManager::Get().IsReadOnly(*Filename)) {
+                    ReadOnly.Add(Package);
+                }
+            }
+        }
+        // チェックアウトできなかったものは保存時に read-only のエラーになる
+        if (!ReadOnly.IsEmpty() && ISourceControlModule::Get().IsEnabled()) {
+            FEditorFileUtils::CheckoutPackages(ReadOnly, nullptr, false, false);
+        }
+
+        auto Job = StartJob(TEXT("level/save"), [State](FJob& Job) {
+            const int32 Num = State->Packages.Num();
+            if (State->Next < Num) {
+                // 1 tick あたりの時間を区切ってエディタの応答性を保つ
+                const double Deadline = FPlatformTime::Seconds() + 0.05;
+                Job.Phase = TEXT("save");
+                do {
+                    UPackage* Package = State->Packages[State->Next++].Get();
+                    if (Package && Package->IsDirty()) {
+                        FString Error;
+                        if (SavePackageAsync(Package, Error)) {
+                            ++State->NumSaved;
+                        }
+                        else {
+                            State->Failed.Add(JObject({
+                                { "package", Package->GetName() },
+                                { "error", Error },
+                                }));
+                        }
+                    }
+                } while (State->Next < Num && FPlatformTime::Seconds() < Deadline);
+                Job.Progress = 0.95f * State->Next / Num;
+                return false;
+            }
+            if (!State->Flushing) {
+                // 書き込みの完了待ちは 1 フレーム後にして、その間も I/O を進めさせる
+                State->Flushing = true;
+                Job.SetPhase(TEXT("flush"), 0.95f);
+                return false;
+            }
+
+            UPackage::WaitForAsyncFileWrites();
+            Job.Result = JObject({
+                { "result", State->Failed.Num() == 0 },
+                { "saved", State->NumSaved },
+                { "failed", State->Failed },
+                });
+            return State->Failed.Num() == 0 ? true : Job.Fail(TEXT("failed to save some packages"));
+            });
+        return ServeJson(Result, MakeJobStarted(Job->Id));
+    }
+
+    auto LevelEditorSubsystem = GEditor->GetEditorSubsystem<ULevelEditorSubsystem>();
+    if (All) {
+        R = LevelEditorSubsystem->SaveAllDirtyLevels();
+    }
+    else {
+        R = LevelEditorSubsystem->SaveCurrentLevel();
+    }
+    return ServeJson(Result, R);
+}
+#pragma endregion Level Commands
+
+
+#pragma region Asset Commands
+static JObject MakeAssetSummary(const FAssetData& Data)
+{
+    return JObject({
+        { "typeName", Data.GetClass()->GetName() },
+        { "assetName", Data.AssetName },
+        { "packageName", Data.PackageName },
+        { "objectPath", GetObectPathStr(Data) },
+        });
+}
+
+// MakeAssetSummary() と同じ内容を arena 上に作る
+static FJsonArenaValue* MakeAssetSummary(FJsonArenaDocument& Doc, const FAssetData& Data)
+{
+    return Doc.MakeObject({
+        { "typeName", Doc.Make(Data.GetClass()->GetFName()) },
+        { "assetName", Doc.Make(Data.AssetName) },
+        { "packageName", Doc.Make(Data.PackageName) },
+        { "objectPath", Doc.Make(GetObectPathStr(Data)) },
+        });
+}
+
+// format=compact 用。typeName は Strings のインデックス、package は Paths のノードのインデックス
+// objectPath は <package>.<assetName> と異なる場合のみ含める
+static JObject MakeAssetSummaryCompact(const FAssetData& Data, FStringTable& Strings, FPathTrie& Paths)
+{
+    JObject Ret({
+        { "typeName", Strings.Add(Data.GetClass()->GetFName()) },
+        { "assetName", Data.AssetName },
+        { "package", Paths.Add(Data.PackageName) },
+        });
+
+    FString ObjectPath = GetObectPathStr(Data);
+    FString PackageName = Data.PackageName.ToString();
+    FString AssetName = Data.AssetName.ToString();
+    if (!(ObjectPath.Len() == PackageName.Len() + 1 + AssetName.Len() && ObjectPath.StartsWith(PackageName) && ObjectPath.EndsWith(AssetName))) {
+        Ret["objectPath"] = ObjectPath;
+    }
+    return Ret;
+}
+
+// /asset/list?filter=class==Texture2D && path~"/Game/Props/*"&format=compact
+// format=compact の場合 { format, strings, paths, items } を返す
+// パッケージ名は paths のトライ木のノードで参照する。パスの復元方法は FPathTrie を参照
+bool FHTTPLinkModule::OnAssetList(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    FString Filter;
+    FString Format;
+    GetQueryParams(Request, {
+        { "filter", Filter },
+        { "format", Format },
+        });
+    const bool Compact = Format == TEXT("compact");
+
+    // アセット数は数十万になり得るので、通常の形式は FJsonValue を個別に確保せず arena 上に構築する
+    JArray Json;
+    FStringTable Strings;
+    FPathTrie Paths(Strings);
+    auto Doc = MakeShared<FJsonArenaDocument>();
+    FJsonArenaValue* Items = Doc->MakeArray();
+    auto AddAsset = [&](const FAssetData& Data) {
+        if (Compact) {
+            Json.Add(MakeAssetSummaryCompact(Data, Strings, Paths));
+        }
+        else {
+            Doc->Add(Items, MakeAssetSummary(*Doc, Data));
+        }
+    };
+    auto ServeList = [&]() {
+        if (Compact) {
+            return ServeJson(Result, {
+                { "format", "compact" },
+                { "strings", Strings.ToJson() },
+                { "paths", Paths.ToJson() },
+                { "items", MoveTemp(Json) },
+                });
+        }
+        Doc->SetRoot(Items);
+        return ServeJson(Result, MoveTemp(Doc));
+    };
+
+    auto& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
+    if (Filter.IsEmpty()) {
+        AssetRegistryModule.Get().EnumerateAllAssets([&](const FAssetData& Data) {
+            AddAsset(Data);
+            return true;
+            });
+        return ServeList();
+    }
+
+    TArray<FAssetData> Assets;
+    AssetRegistryModule.Get().GetAllAssets(Assets);
+    FString Error;
+    bool Ok = EachFiltered(GetQueryFilters().Assets, Filter, Assets, Error, AddAsset);
+    if (!Ok) {
+        return ServeJson(Result, { { "result", false }, { "error", Error } });
+    }
+    return ServeList();
+}
+
+// アセットの依存関係グラフ
+// アセットレジストリのパッケージ単位の依存を CSR (隣接リストを 1 本の配列に詰めたもの) に変換して保持する。
+// 正方向 (依存先) と逆方向 (参照元) の両方を持ち、探索は深さごとのフロンティアをワーカースレッドで並列に展開する。
+// レジストリが変化したら次のクエリで作り直す。クエリ結果も作り直すまではキャッシュする
+struct FHTTPLinkModule::FAssetGraph
+{
+    // Nodes はパッケージ名。/Script/... などアセットを持たないパッケージも依存先として現れる
+    TArray<FName> Nodes;
+    TArray<FName> Classes;
+    TMap<FName, int32> Indices;
+    // Deps[DepBegin[I]] ～ Deps[DepBegin[I + 1] - 1] が I の依存先
+    TArray<int32> DepBegin;
+    TArray<int32> Deps;
+    TArray<int32> RefBegin;
+    TArray<int32> Refs;
+    bool bDirty = true;
+
+    TMap<FString, TSharedPtr<FJsonValue>> Results;
+    static constexpr int32 MaxResults = 256;
+
+    FDelegateHandle HAssetAdded;
+    FDelegateHandle HAssetRemoved;
+    FDelegateHandle HAssetRenamed;
+    FDelegateHandle HAssetUpdated;
+    FDelegateHandle HFilesLoaded;
+
+    FAssetGraph()
+    {
+        auto& Registry = GetAssetRegistry();
+        HAssetAdded = Registry.OnAssetAdded().AddLambda([this](const FAssetData&) { bDirty = true; });
+        HAssetRemoved = Registry.OnAssetRemoved().AddLambda([this](const FAssetData&) { bDirty = true; });
+        HAssetRenamed = Registry.OnAssetRenamed().AddLambda([this](const FAssetData&, const FString&) { bDirty = true; });
+#if ENGINE_MAJOR_VERSION >= 5
+        // 保存などで依存が変わった場合
+        HAssetUpdated = Registry.OnAssetUpdated().AddLambda([this](const FAssetData&) { bDirty = true; });
+#endif
+        HFilesLoaded = Registry.OnFilesLoaded().AddLambda([this]() { bDirty = true; });
+    }
+
+    ~FAssetGraph()
+    {
+        if (auto* AssetRegistryModule = FModuleManager::GetModulePtr<FAssetRegistryModule>("AssetRegistry")) {
+            auto& Registry = AssetRegistryModule->Get();
+            Registry.OnAssetAdded().Remove(HAssetAdded);
+            Registry.OnAssetRemoved().Remove(HAssetRemoved);
+            Registry.OnAssetRenamed().Remove(HAssetRenamed);
+#if ENGINE_MAJOR_VERSION >= 5
+            Registry.OnAssetUpdated().Remove(HAssetUpdated);
+#endif
+            Registry.OnFilesLoaded().Remove(HFilesLoaded);
+        }
+    }
+
+    int32 GetOrAdd(FName Package)
+    {
+        if (const int32* Found = Indices.Find(Package)) {
+            return *Found;
+        }
+        int32 Index = Nodes.Add(Package);
+        Classes.Add(NAME_None);
+        Indices.Add(Package, Index);
+        return Index;
+    }
+
+    void Validate()
+    {
+        if (!bDirty) {
+            return;
+        }
+        bDirty = false;
+        Results.Empty();
+
+        auto& Registry = GetAssetRegistry();
+        TArray<FAssetData> Assets;
+        Registry.GetAllAssets(Assets);
+
+        Nodes.Reset();
+        Classes.Reset();
+        Indices.Reset();
+        Indices.Reserve(Assets.Num());
+        for (auto& Asset : Assets) {
+            int32 Index = GetOrAdd(Asset.PackageName);
+            if (Classes[Index].IsNone()) {
+#if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 1
+                Classes[Index] = Asset.AssetClassPath.GetAssetName();
+#else
+                Classes[Index] = Asset.AssetClass;
+#endif
+            }
+        }
+
+        // 正方向の辺。依存先として初めて現れたノードはここで増える
+        TArray<TPair<int32, int32>> Edges;
+        TArray<FName> Dependencies;
+        const int32 NumPackages = Nodes.Num();
+        for (int32 I = 0; I < NumPackages; ++I) {
+            Dependencies.Reset();
+            Registry.GetDependencies(Nodes[I], Dependencies, UE::AssetRegistry::EDependencyCategory::Package);
+            for (FName Dep : Dependencies) {
+                Edges.Emplace(I, GetOrAdd(Dep));
+            }
+        }
+
+        auto BuildCSR = [&](bool Forward, TArray<int32>& Begin, TArray<int32>& Dst) {
+            const int32 Num = Nodes.Num();
+            Begin.Init(0, Num + 1);
+            for (auto& E : Edges) {
+                ++Begin[(Forward ? E.Key : E.Value) + 1];
+            }
+            for (int32 I = 0; I < Num; ++I) {
+                Begin[I + 1] += Begin[I];
+            }
+            Dst.SetNumUninitialized(Edges.Num());
+            TArray<int32> Cursor(Begin.GetData(), Num);
+            for (auto& E : Edges) {
+                Dst[Cursor[Forward ? E.Key : E.Value]++] = Forward ? E.Value : E.Key;
+            }
+        };
+        BuildCSR(true, DepBegin, Deps);
+        BuildCSR(false, RefBegin, Refs);
+    }
+
+    // Roots から辿れるノードと深さ (Roots 自身は含まない)。MaxDepth が負の場合は無制限
+    // 深さごとにフロンティアを ChunkSize 単位に分けて並列に展開する。訪問済みフラグは CAS で取るので各ノードは 1 度だけ現れる
+    TArray<TPair<int32, int32>> Traverse(TArrayView<const int32> Roots, bool Forward, int32 MaxDepth, int32 ChunkSize = 256) const
+    {
+        const TArray<int32>& Begin = Forward ? DepBegin : RefBegin;
+        const TArray<int32>& Edges = Forward ? Deps : Refs;
+
+        TUniquePtr<std::atomic<uint8>[]> Visited(new std::atomic<uint8>[Nodes.Num()]);
+        for (int32 I = 0; I < Nodes.Num(); ++I) {
+            Visited[I].store(0, std::memory_order_relaxed);
+        }
+        TArray<int32> Frontier;
+        for (int32 Root : Roots) {
+            if (!Visited[Root].exchange(1)) {
+                Frontier.Add(Root);
+            }
+        }
+
+        TArray<TPair<int32, int32>> Ret;
+        TArray<TArray<int32>> Next;
+        for (int32 Depth = 1; Frontier.Num() && (MaxDepth < 0 || Depth <= MaxDepth); ++Depth) {
+            const int32 NumChunks = FMath::DivideAndRoundUp(Frontier.Num(), ChunkSize);
+            Next.SetNum(NumChunks);
+            ParallelFor(NumChunks, [&](int32 Chunk) {
+                TArray<int32>& Dst = Next[Chunk];
+                Dst.Reset();
+                const int32 ChunkEnd = FMath::Min((Chunk + 1) * ChunkSize, Frontier.Num());
+                for (int32 I = Chunk * ChunkSize; I < ChunkEnd; ++I) {
+                    const int32 Node = Frontier[I];
+                    for (int32 E = Begin[Node]; E < Begin[Node + 1]; ++E) {
+                        const int32 To = Edges[E];
+                        uint8 Expected = 0;
+                        if (Visited[To].compare_exchange_strong(Expected, 1)) {
+                            Dst.Add(To);
+                        }
+                    }
+                }
+                }, NumChunks == 1);
+
+            Frontier.Reset();
+            for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk) {
+                Frontier.Append(Next[Chunk]);
+            }
+            for (int32 Node : Frontier) {
+                Ret.Emplace(Node, Depth);
+            }
+        }
+        return Ret;
+    }
+};
+
+FHTTPLinkModule::FAssetGraph& FHTTPLinkModule::GetAssetGraph()
+{
+    if (!AssetGraph) {
+        AssetGraph = MakeShared<FAssetGraph>();
+    }
+    AssetGraph->Validate();
+    return *AssetGraph;
+}
+
+// /asset/dependencies と /asset/referencers の共通部分
+//   package=/Game/Props/SM_Rock (packages=[...] で複数、objectPath= も可)
+//   depth=n  辿る段数。省略時や負の場合は推移閉包全体
+//   classes=Texture2D,Material  結果をアセットのクラスで絞り込む (探索自体は全ノードを通る)
+// 結果は [{ package, class, depth }] を深さ順に
+bool FHTTPLinkModule::ServeAssetGraphQuery(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result, bool Forward)
+{
+    FString Package;
+    TArray<FString> Packages;
+    FString ObjectPath;
+    int32 Depth = -1;
+    FString ClassesStr;
+    GetQueryParams(Request, {
+        { "package", Package }, { "packages", Packages }, { "objectPath", ObjectPath }, { "depth", Depth }, { "classes", ClassesStr },
+        });
+    if (!Package.IsEmpty()) {
+        Packages.Add(Package);
+    }
+    if (!ObjectPath.IsEmpty()) {
+        Packages.Add(FPackageName::ObjectPathToPackageName(ObjectPath));
+    }
+    if (Packages.IsEmpty()) {
+        return ServeJson(Result, false);
+    }
+
+    auto& Graph = GetAssetGraph();
+    TArray<int32> Roots;
+    JArray Missing;
+    for (auto& P : Packages) {
+        if (const int32* Index = Graph.Indices.Find(FName(*P))) {
+            Roots.AddUnique(*Index);
+        }
+        else {
+            Missing.Add(P);
+        }
+    }
+
+    // 同じクエリはグラフを作り直すまで結果を使い回す
+    TArray<FString> ClassNames;
+    ClassesStr.ParseIntoArray(ClassNames, TEXT(","));
+    ClassNames.Sort();
+    TArray<int32> SortedRoots = Roots;
+    SortedRoots.Sort();
+    FString Key = FString::Printf(TEXT("%d|%d|%s|"), Forward ? 1 : 0, Depth, *FString::Join(ClassNames, TEXT(",")));
+    for (int32 Root : SortedRoots) {
+        Key += FString::Printf(TEXT("%d,"), Root);
+    }
+    if (Missing.IsEmpty()) {
+        if (auto* Cached = Graph.Results.Find(Key)) {
+            return ServeJsonValue(Result, CopyTemp(*Cached));
+        }
+    }
+
+    TSet<FName> ClassFilter;
+    for (auto& C : ClassNames) {
+        ClassFilter.Add(FName(*C.TrimStartAndEnd()));
+    }
+
+    auto Reached = Graph.Traverse(Roots, Forward, Depth);
+    JArray Items;
+    Items.Reserve(Reached.Num());
+    for (auto& R : Reached) {
+        const FName Class = Graph.Classes[R.Key];
+        if (ClassFilter.Num() && !ClassFilter.Contains(Class)) {
+            continue;
+        }
+        Items.Add(JObject({
+            { "package", Graph.Nodes[R.Key] },
+            { "class", Class.IsNone() ? FString() : Class.ToString() },
+            { "depth", R.Value },
+            }));
+    }
+
+    JObject Json({
+        { "result", true },
+        { "count", Items.Num() },
+        { "packages", MoveTemp(Items) },
+        });
+    if (!Missing.IsEmpty()) {
+        Json["missing"] = MoveTemp(Missing);
+        return ServeJson(Result, MoveTemp(Json));
+    }
+    if (Graph.Results.Num() >= FAssetGraph::MaxResults) {
+        Graph.Results.Empty();
+    }
+    TSharedPtr<FJsonValue> Value = MoveTemp(Json).ToValue();
+    Graph.Results.Add(Key, Value);
+    return ServeJsonValue(Result, MoveTemp(Value));
+}
+
+// /asset/dependencies?package=/Game/Maps/Level&depth=2&classes=Texture2D
+bool FHTTPLinkModule::OnAssetDependencies(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    return ServeAssetGraphQuery(Request, Result, true);
+}
+
+// /asset/referencers?package=/Game/Textures/T_Rock
+bool FHTTPLinkModule::OnAssetReferencers(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    return ServeAssetGraphQuery(Request, Result, false);
+}
+
+// アセットのサムネイル
+// 探す順序は メモリ上のキャッシュ → ディスク上のキャッシュ → パッケージに保存されているサムネイル → レンダリング
+// レンダリングはアセットのロードを伴うので、リクエストの処理中には行わない。非同期ロードを投げてキューに積み、
+// ロードが終わったものから TickThumbnails() で 1 フレームあたり ThumbnailRenderBudget 秒の範囲でまとめて処理する
+// ディスク上のキャッシュは Saved/HTTPLink/Thumbnails/<hash>.png。hash は (objectPath, size, パッケージの更新日時) から作るので、
+// 保存し直されたアセットは別のエントリになり、古いものは容量を超えたときに最終アクセスの古い順に消える
+struct FHTTPLinkModule::FThumbnailCache
+{
+    struct FMemoryEntry
+    {
+        TArray<uint8> Png;
+        FString Hash;
+        FName PackageName;
+        uint64 LastUse = 0;
+    };
+    struct FDiskEntry
+    {
+        int64 Size = 0;
+        FDateTime LastAccess;
+    };
+    struct FPending
+    {
+        FAssetData Asset;
+        int32 Size = 0;
+        FString Hash;
+        bool bLoaded = false;
+        TArray<FHTTPLinkResultCallback> Waiters;
+    };
+
+    FString Directory;
+    int64 MemoryCapacity = 0;
+    int64 DiskCapacity = 0;
+
+    // キーは "objectPath|size"
+    TMap<FString, FMemoryEntry> Memory;
+    int64 MemoryBytes = 0;
+    uint64 UseCounter = 0;
+    // キーは hash
+    TMap<FString, FDiskEntry> Disk;
+    int64 DiskBytes = 0;
+    // キーは Memory と同じ。Queue は到着順
+    TMap<FString, FPending> Pending;
+    TArray<FString> Queue;
+
+    int64 NumMemoryHits = 0;
+    int64 NumDiskHits = 0;
+    int64 NumExtracted = 0;
+    int64 NumRendered = 0;
+    int64 NumEvictions = 0;
+
+    FDelegateHandle HAssetRemoved;
+    FDelegateHandle HAssetRenamed;
+    FDelegateHandle HPackageSaved;
+
+    FThumbnailCache(int64 InMemoryCapacity, int64 InDiskCapacity)
+        : MemoryCapacity(InMemoryCapacity)
+        , DiskCapacity(InDiskCapacity)
+    {
+        Directory = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir() / TEXT("HTTPLink/Thumbnails"));
+        IFileManager::Get().MakeDirectory(*Directory, true);
+        IFileManager::Get().IterateDirectoryStat(*Directory, [this](const TCHAR* Path, const FFileStatData& Stat) {
+            if (!Stat.bIsDirectory && FPaths::GetExtension(Path) == TEXT("png")) {
+                Disk.Add(FPaths::GetBaseFilename(Path), { Stat.FileSize, Stat.ModificationTime });
+                DiskBytes += Stat.FileSize;
+            }
+            return true;
+            });
+        EvictDisk();
+
+        // ディスク上のエントリは hash が変わるので放っておけばよいが、メモリ上のものは明示的に捨てる
+        auto& Registry = GetAssetRegistry();
+        HAssetRemoved = Registry.OnAssetRemoved().AddLambda([this](const FAssetData& Asset) { InvalidatePackage(Asset.PackageName); });
+        HAssetRenamed = Registry.OnAssetRenamed().AddLambda([this](const FAssetData&, const FString& OldObjectPath) {
+            InvalidatePackage(FName(*FPackageName::ObjectPathToPackageName(OldObjectPath)));
+            });
+#if ENGINE_MAJOR_VERSION >= 5
+        HPackageSaved = Registry.OnAssetUpdated().AddLambda([this](const FAssetData& Asset) { InvalidatePackage(Asset.PackageName); });
+#else
+        HPackageSaved = UPackage::PackageSavedEvent.AddLambda([this](const FString&, UObject* Package) { InvalidatePackage(Package->GetFName()); });
+#endif
+    }
+
+    ~FThumbnailCache()
+    {
+        if (auto* AssetRegistryModule = FModuleManager::GetModulePtr<FAssetRegistryModule>("AssetRegistry")) {
+            auto& Registry = AssetRegistryModule->Get();
+            Registry.OnAssetRemoved().Remove(HAssetRemoved);
+            Registry.OnAssetRenamed().Remove(HAssetRenamed);
+#if ENGINE_MAJOR_VERSION >= 5
+            Registry.OnAssetUpdated().Remove(HPackageSaved);
+#endif
+        }
+#if ENGINE_MAJOR_VERSION < 5
+        UPackage::PackageSavedEvent.Remove(HPackageSaved);
+#endif
+    }
+
+    static FString MakeKey(const FString& ObjectPath, int32 Size)
+    {
+        return FString::Printf(TEXT("%s|%d"), *ObjectPath, Size);
+    }
+
+    static FString MakeHash(const FString& ObjectPath, int32 Size, const FDateTime& PackageTime)
+    {
+        return FMD5::HashAnsiString(*FString::Printf(TEXT("%s|%d|%lld"), *ObjectPath, Size, PackageTime.GetTicks()));
+    }
+
+    FString GetFilePath(const FString& Hash) const
+    {
+        return Directory / Hash + TEXT(".png");
+    }
+
+    const FMemoryEntry* FindMemory(const FString& Key)
+    {
+        if (FMemoryEntry* Entry = Memory.Find(Key)) {
+            Entry->LastUse = ++UseCounter;
+            ++NumMemoryHits;
+            return Entry;
+        }
+        return nullptr;
+    }
+
+    bool LoadDisk(const FString& Hash, TArray<uint8>& Dst)
+    {
+        FDiskEntry* Entry = Disk.Find(Hash);
+        if (!Entry) {
+            return false;
+        }
+        const FString Path = GetFilePath(Hash);
+        if (!FFileHelper::LoadFileToArray(Dst, *Path)) {
+            DiskBytes -= Entry->Size;
+            Disk.Remove(Hash);
+            return false;
+        }
+        // 最終アクセスは更新日時として残しておき、次回起動時の LRU の順序に使う
+        Entry->LastAccess = FDateTime::UtcNow();
+        IFileManager::Get().SetTimeStamp(*Path, Entry->LastAccess);
+        ++NumDiskHits;
+        return true;
+    }
+
+    void Store(const FString& Key, const FString& Hash, FName PackageName, const TArray<uint8>& Png, bool bToDisk)
+    {
+        if (bToDisk && FFileHelper::SaveArrayToFile(Png, *GetFilePath(Hash))) {
+            if (FDiskEntry* Old = Disk.Find(Hash)) {
+                DiskBytes -= Old->Size;
+            }
+            Disk.Add(Hash, { Png.Num(), FDateTime::UtcNow() });
+            DiskBytes += Png.Num();
+            EvictDisk();
+        }
+
+        if (FMemoryEntry* Old = Memory.Find(Key)) {
+            MemoryBytes -= Old->Png.Num();
+        }
+        Memory.Add(Key, { Png, Hash, PackageName, ++UseCounter });
+        MemoryBytes += Png.Num();
+        while (MemoryBytes > MemoryCapacity && Memory.Num() > 1) {
+            auto Oldest = Memory.CreateIterator();
+            for (auto It = Memory.CreateIterator(); It; ++It) {
+                if (It->Value.LastUse < Oldest->Value.LastUse) {
+                    Oldest = It;
+                }
+            }
+            MemoryBytes -= Oldest->Value.Png.Num();
+            Oldest.RemoveCurrent();
+            ++NumEvictions;
+        }
+    }
+
+    // 容量を超えていたら最終アクセスの古い順に 90% まで減らす
+    void EvictDisk()
+    {
+        if (DiskBytes <= DiskCapacity) {
+            return;
+        }
+        TArray<TPair<FDateTime, FString>> Order;
+        Order.Reserve(Disk.Num());
+        for (auto& KVP : Disk) {
+            Order.Emplace(KVP.Value.LastAccess, KVP.Key);
+        }
+        Order.Sort([](auto& A, auto& B) { return A.Key < B.Key; });
+        const int64 Target = DiskCapacity / 10 * 9;
+        for (auto& O : Order) {
+            if (DiskBytes <= Target) {
+                break;
+            }
+            IFileManager::Get().Delete(*GetFilePath(O.Value), false, true, true);
+            DiskBytes -= Disk[O.Value].Size;
+            Disk.Remove(O.Value);
+            ++NumEvictions;
+        }
+    }
+
+    void InvalidatePackage(FName PackageName)
+    {
+        for (auto It = Memory.CreateIterator(); It; ++It) {
+            if (It->Value.PackageName == PackageName) {
+                MemoryBytes -= It->Value.Png.Num();
+                It.RemoveCurrent();
+            }
+        }
+    }
+
+    void ClearMemory()
+    {
+        Memory.Empty();
+        MemoryBytes = 0;
+    }
+
+    JObject ToJson() const
+    {
+        return JObject({
+            { "memoryEntries", Memory.Num() },
+            { "memoryBytes", MemoryBytes },
+            { "memoryCapacity", MemoryCapacity },
+            { "diskEntries", Disk.Num() },
+            { "diskBytes", DiskBytes },
+            { "diskCapacity", DiskCapacity },
+            { "pending", Pending.Num() },
+            { "memoryHits", NumMemoryHits },
+            { "diskHits", NumDiskHits },
+            { "extracted", NumExtracted },
+            { "rendered", NumRendered },
+            { "evictions", NumEvictions },
+            });
+    }
+};
+
+FHTTPLinkModule::FThumbnailCache& FHTTPLinkModule::GetThumbnailCache()
+{
+    if (!ThumbnailCache) {
+        ThumbnailCache = MakeShared<FThumbnailCache>(ThumbnailMemoryCapacity, ThumbnailDiskCapacity);
+    }
+    return *ThumbnailCache;
+}
+
+// FObjectThumbnail (BGRA8) を長辺 Size の PNG にする
+static TArray<uint8> EncodeThumbnailPng(const FObjectThumbnail& Thumbnail, int32 Size)
+{
+    int32 Width = Thumbnail.GetImageWidth();
+    int32 Height = Thumbnail.GetImageHeight();
+    if (Thumbnail.IsEmpty()) {
+        return {};
+    }
+    const TArray<uint8>& Raw = Thumbnail.GetUncompressedImageData();
+    if (Raw.Num() < Width * Height * (int32)sizeof(FColor)) {
+        return {};
+    }
+
+    // アルファは意味を持たない (0 のこともある) ので不透明にする
+    TArray<FColor> Pixels;
+    Pixels.SetNumUninitialized(Width * Height);
+    FMemory::Memcpy(Pixels.GetData(), Raw.GetData(), Pixels.Num() * sizeof(FColor));
+    for (FColor& C : Pixels) {
+        C.A = 255;
+    }
+
+    const int32 DstWidth = Width >= Height ? Size : FMath::Max(1, Width * Size / Height);
+    const int32 DstHeight = Width >= Height ? FMath::Max(1, Height * Size / Width) : Size;
+    if (DstWidth != Width || DstHeight != Height) {
+        TArray<FColor> Resized;
+        FImageUtils::ImageResize(Width, Height, Pixels, DstWidth, DstHeight, Resized, false);
+        Pixels = MoveTemp(Resized);
+        Width = DstWidth;
+        Height = DstHeight;
+    }
+
+    auto& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
+    TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+    if (!ImageWrapper || !ImageWrapper->SetRaw(Pixels.GetData(), Pixels.Num() * sizeof(FColor), Width, Height, ERGBFormat::BGRA, 8)) {
+        return {};
+    }
+    const auto& Compressed = ImageWrapper->GetCompressed();
+    return TArray<uint8>(Compressed.GetData(), (int32)Compressed.Num());
+}
+
+// ロード済みのオブジェクトがメモリ上に持っているサムネイルか、パッケージファイルに保存されているサムネイル
+// どちらもパッケージのロードは伴わない
+static bool FindStoredThumbnail(const FAssetData& Asset, const FString& PackageFile, FObjectThumbnail& Dst)
+{
+    const FString FullName = Asset.GetFullName();
+    if (const FObjectThumbnail* Cached = ThumbnailTools::FindCachedThumbnail(FullName)) {
+        if (!Cached->IsEmpty()) {
+            Dst = *Cached;
+            return true;
+        }
+    }
+    if (!PackageFile.IsEmpty()) {
+        const FName ObjectFullName(*FullName);
+        FThumbnailMap Thumbnails;
+        ThumbnailTools::LoadThumbnailsFromPackage(PackageFile, { ObjectFullName }, Thumbnails);
+        if (FObjectThumbnail* Loaded = Thumbnails.Find(ObjectFullName)) {
+            if (!Loaded->IsEmpty()) {
+                Dst = MoveTemp(*Loaded);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static bool ServeThumbnail(const FHTTPLinkResultCallback& Result, TArray<uint8>&& Png, const FString& Hash)
+{
+    FHTTPLinkResponse Response;
+    Response.ContentType = "image/png";
+    Response.Body = MoveTemp(Png);
+    Response.Headers.Add(TEXT("ETag"), { FString::Printf(TEXT("\"%s\""), *Hash) });
+    Result(MoveTemp(Response));
+    return true;
+}
+
+// /asset/thumbnail?objectPath=/Game/Props/SM_Rock.SM_Rock&size=128
+// size は長辺のピクセル数 (16 ～ 1024、既定 256)。PNG を返す
+// キャッシュにもパッケージにもないものはレンダリングが終わるまで応答を保留する
+bool FHTTPLinkModule::OnAssetThumbnail(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    FString ObjectPath;
+    int32 Size = ThumbnailTools::DefaultThumbnailSize;
+    GetQueryParams(Request, {
+        { "objectPath", ObjectPath }, { "size", Size },
+        });
+    Size = FMath::Clamp(Size, 16, 1024);
+
+    FAssetData Asset = GetAssetByObjectPath(ObjectPath);
+    if (!Asset.IsValid()) {
+        return Serve(Result, {}, "text/plain", EHttpServerResponseCodes::NotFound);
+    }
+
+    auto& Cache = GetThumbnailCache();
+    const FString Key = FThumbnailCache::MakeKey(ObjectPath, Size);
+    if (auto* Entry = Cache.FindMemory(Key)) {
+        return ServeThumbnail(Result, CopyTemp(Entry->Png), Entry->Hash);
+    }
+    if (auto* P = Cache.Pending.Find(Key)) {
+        P->Waiters.Add(Result);
+        return true;
+    }
+
+    FString PackageFile;
+    FDateTime PackageTime = FDateTime::MinValue();
+    if (FPackageName::DoesPackageExist(Asset.PackageName.ToString(), &PackageFile)) {
+        PackageTime = IFileManager::Get().GetTimeStamp(*PackageFile);
+    }
+    const FString Hash = FThumbnailCache::MakeHash(ObjectPath, Size, PackageTime);
+
+    TArray<uint8> Png;
+    if (Cache.LoadDisk(Hash, Png)) {
+        Cache.Store(Key, Hash, Asset.PackageName, Png, false);
+        return ServeThumbnail(Result, MoveTemp(Png), Hash);
+    }
+
+    FObjectThumbnail Thumbnail;
+    if (FindStoredThumbnail(Asset, PackageFile, Thumbnail)) {
+        Png = EncodeThumbnailPng(Thumbnail, Size);
+        if (Png.Num()) {
+            ++Cache.NumExtracted;
+            Cache.Store(Key, Hash, Asset.PackageName, Png, true);
+            return ServeThumbnail(Result, MoveTemp(Png), Hash);
+        }
+    }
+
+    // レンダリング待ち。パッケージのロードは先に非同期で始めておく
+    auto& P = Cache.Pending.Add(Key);
+    P.Asset = Asset;
+    P.Size = Size;
+    P.Hash = Hash;
+    P.Waiters.Add(Result);
+    Cache.Queue.Add(Key);
+    if (Asset.IsAssetLoaded()) {
+        P.bLoaded = true;
+    }
+    else {
+        TWeakPtr<FThumbnailCache> WeakCache = ThumbnailCache;
+        LoadPackageAsync(Asset.PackageName.ToString(), FLoadPackageAsyncDelegate::CreateLambda(
+            [WeakCache, Key](const FName&, UPackage*, EAsyncLoadingResult::Type) {
+                // 失敗した場合も TickThumbnails() に回して応答させる
+                if (auto Cache = WeakCache.Pin()) {
+                    if (auto* P = Cache->Pending.Find(Key)) {
+                        P->bLoaded = true;
+                    }
+                }
+            }));
+    }
+    return true;
+}
+
+void FHTTPLinkModule::TickThumbnails()
+{
+    if (!ThumbnailCache || ThumbnailCache->Queue.IsEmpty()) {
+        return;
+    }
+    auto& Cache = *ThumbnailCache;
+
+    // ロードが済んだものを予算の範囲でまとめてレンダリングする。最低 1 つは進める
+    const double Begin = FPlatformTime::Seconds();
+    int32 NumProcessed = 0;
+    for (int32 I = 0; I < Cache.Queue.Num();) {
+        if (NumProcessed > 0 && FPlatformTime::Seconds() - Begin >= ThumbnailRenderBudget) {
+            break;
+        }
+        const FString Key = Cache.Queue[I];
+        FThumbnailCache::FPending* P = Cache.Pending.Find(Key);
+        if (P && !P->bLoaded) {
+            ++I;
+            continue;
+        }
+        Cache.Queue.RemoveAt(I);
+        if (!P) {
+            continue;
+        }
+        FThumbnailCache::FPending Item = MoveTemp(*P);
+        Cache.Pending.Remove(Key);
+        ++NumProcessed;
+
+        TArray<uint8> Png;
+        if (UObject* Object = Item.Asset.GetAsset()) {
+            FObjectThumbnail Thumbnail;
+            ThumbnailTools::RenderThumbnail(Object, Item.Size, Item.Size, ThumbnailTools::EThumbnailTextureFlushMode::AlwaysFlush, nullptr, &Thumbnail);
+            Png = EncodeThumbnailPng(Thumbnail, Item.Size);
+        }
+        if (Png.Num()) {
+            ++Cache.NumRendered;
+            Cache.Store(Key, Item.Hash, Item.Asset.PackageName, Png, true);
+            for (auto& Waiter : Item.Waiters) {
+                ServeThumbnail(Waiter, CopyTemp(Png), Item.Hash);
+            }
+        }
+        else {
+            for (auto& Waiter : Item.Waiters) {
+                Serve(Waiter, {}, "text/plain", EHttpServerResponseCodes::NotFound);
+            }
+        }
+    }
+}
+
+// インポートの単位。テクスチャの画像はワーカースレッドでデコードしておき、
+// UObject の生成 (とテクスチャ以外のファクトリによるインポート) はゲームスレッドで行う
+struct FAssetImportItem
+{
+    FString File;
+    FString Destination;
+    bool bTexture = false;
+    bool bCommitted = false;
+
+    // デコード結果。Decode が完了するまではワーカースレッドのみが触る
+    TFuture<void> Decode;
+    TArray64<uint8> Pixels;
+    ETextureSourceFormat SourceFormat = TSF_Invalid;
+    int32 Width = 0;
+    int32 Height = 0;
+
+    bool bOk = false;
+    FString Error;
+    TArray<FString> Objects;
+    double DecodeTime = 0.0;
+    double CommitTime = 0.0;
+
+    bool IsReady() const { return !Decode.IsValid() || Decode.IsReady(); }
+
+    JObject ToJson() const
+    {
+        JObject Ret({
+            { "file", File },
+            { "destination", Destination },
+            { "result", bOk },
+            { "objects", Objects },
+            { "decodeMs", DecodeTime * 1000.0 },
+            { "commitMs", CommitTime * 1000.0 },
+            });
+        if (!Error.IsEmpty()) {
+            Ret["error"] = Error;
+        }
+        return Ret;
+    }
+};
+
+static bool IsImageFile(const FString& File)
+{
+    static const TCHAR* Extensions[] = { TEXT("png"), TEXT("jpg"), TEXT("jpeg"), TEXT("bmp"), TEXT("tga") };
+    const FString Ext = FPaths::GetExtension(File);
+    for (const TCHAR* E : Extensions) {
+        if (Ext == E) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 画素を間引いて調べ、ほぼすべてが長さ 1 で +Z 向きのベクトルとして読めるならノーマルマップとみなす
+// ファクトリはノーマルマップを検出すると圧縮設定などを変えるので、該当しそうなものはファクトリに任せるための判定
+template<class T>
+static bool LooksLikeNormalMap(const T* Pixels, int64 NumPixels, int32 R, int32 G, int32 B)
+{
+    const int64 NumSamples = FMath::Min<int64>(NumPixels, 4096);
+    if (NumSamples == 0) {
+        return false;
+    }
+    const int64 Stride = NumPixels / NumSamples;
+    const float Scale = 2.0f / TNumericLimits<T>::Max();
+    int64 NumNormals = 0;
+    for (int64 I = 0; I < NumSamples; ++I) {
+        const T* Pixel = Pixels + I * Stride * 4;
+        const FVector N(Pixel[R] * Scale - 1.0f, Pixel[G] * Scale - 1.0f, Pixel[B] * Scale - 1.0f);
+        if (N.Z > 0.0f && FMath::Abs(N.Size() - 1.0f) < 0.1f) {
+            ++NumNormals;
+        }
+    }
+    return NumNormals >= NumSamples * 9 / 10;
+}
+
+// ワーカースレッドで呼ばれる。
+// 画素をそのまま保てるフォーマット (8/16 bit の RGBA とグレースケール) のみここでデコードし、
+// それ以外 (HDR など) やノーマルマップらしきもの、デコードに失敗したものはファクトリによるインポートにフォールバックする
+static void DecodeImageFile(IImageWrapperModule& ImageWrapperModule, FAssetImportItem& Item)
+{
+    const double Begin = FPlatformTime::Seconds();
+    TArray<uint8> Compressed;
+    if (FFileHelper::LoadFileToArray(Compressed, *Item.File)) {
+        EImageFormat Format = ImageWrapperModule.DetectImageFormat(Compressed.GetData(), Compressed.Num());
+        TSharedPtr<IImageWrapper> ImageWrapper = Format != EImageFormat::Invalid ? ImageWrapperModule.CreateImageWrapper(Format) : nullptr;
+        if (ImageWrapper && ImageWrapper->SetCompressed(Compressed.GetData(), Compressed.Num())) {
+            const ERGBFormat RGBFormat = ImageWrapper->GetFormat();
+            const int32 BitDepth = ImageWrapper->GetBitDepth();
+            const bool bColor = RGBFormat == ERGBFormat::RGBA || RGBFormat == ERGBFormat::BGRA;
+            const bool bGray = RGBFormat == ERGBFormat::Gray;
+            if (bColor && BitDepth == 8 && ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, Item.Pixels)) {
+                Item.SourceFormat = TSF_BGRA8;
+            }
+            else if (bColor && BitDepth == 16 && ImageWrapper->GetRaw(ERGBFormat::RGBA, 16, Item.Pixels)) {
+                Item.SourceFormat = TSF_RGBA16;
+            }
+            else if (bGray && BitDepth == 8 && ImageWrapper->GetRaw(ERGBFormat::Gray, 8, Item.Pixels)) {
+                Item.SourceFormat = TSF_G8;
+            }
+            else if (bGray && BitDepth == 16 && ImageWrapper->GetRaw(ERGBFormat::Gray, 16, Item.Pixels)) {
+                Item.SourceFormat = TSF_G16;
+            }
+            Item.Width = ImageWrapper->GetWidth();
+            Item.Height = ImageWrapper->GetHeight();
+        }
+    }
 
-    if (GUID.IsValid()) {
-        // GUID で 検索 (一意)
-        return [World, GUID]() { return FindActor(World, [&](AActor* A) { return A->GetActorGuid() == GUID; }); };
+    const int64 NumPixels = (int64)Item.Width * Item.Height;
+    bool bNormalMap = false;
+    if (Item.SourceFormat == TSF_BGRA8) {
+        bNormalMap = LooksLikeNormalMap(Item.Pixels.GetData(), NumPixels, 2, 1, 0);
     }
-    else if (!Name.IsNone()) {
-        // FName で検索 (一意)
-        return [World, Name]() { return FindActor(World, [&](AActor* A) { return A->GetFName() == Name; }); };
+    else if (Item.SourceFormat == TSF_RGBA16) {
+        bNormalMap = LooksLikeNormalMap((const uint16*)Item.Pixels.GetData(), NumPixels, 0, 1, 2);
     }
-    else if (!Label.IsEmpty()) {
-        // Label で検索 (一意ではない)
-        return [World, Label]() { return FindActor(World, [&](AActor* A) { return A->GetActorLabel() == Label; }); };
+    if (Item.SourceFormat == TSF_Invalid || Item.Pixels.IsEmpty() || bNormalMap) {
+        Item.Pixels.Empty();
+        Item.bTexture = false;
     }
-    // Unique ID は変動しうるので対応しない
-    return {};
+    Item.DecodeTime = FPlatformTime::Seconds() - Begin;
 }
 
-bool FHTTPLinkModule::OnActorSelect(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
+// デコード済みの画像から UTexture2D を作る。同名のテクスチャがあれば上書きする
+static void CommitTexture(FAssetImportItem& Item)
 {
-    bool R = false;
-    bool Additive = false;
-    TFunction<AActor* ()> Finder = GetActorFinder(Request, { {"additive", Additive} });
+    const FString Name = ObjectTools::SanitizeObjectName(FPaths::GetBaseFilename(Item.File));
+    const FString PackageName = Item.Destination / Name;
+    if (!FPackageName::IsValidLongPackageName(PackageName)) {
+        Item.Error = FString::Printf(TEXT("invalid package name: %s"), *PackageName);
+        return;
+    }
+    UPackage* Package = CreatePackage(*PackageName);
+    Package->FullyLoad();
 
-    if (Finder) {
-        if (!Additive) {
-            GEditor->SelectNone(true, false);
-        }
-        if (AActor* Actor = Finder()) {
-            GEditor->SelectActor(Actor, true, true, true);
-            R = true;
-        }
+    // 同名の別クラスのオブジェクトがあると NewObject が fatal になるので、上書きできない場合はエラーにする
+    UObject* Existing = FindObject<UObject>(Package, *Name);
+    UTexture2D* Texture = Cast<UTexture2D>(Existing);
+    if (Existing && !Texture) {
+        Item.Error = FString::Printf(TEXT("%s already exists as %s"), *Existing->GetPathName(), *Existing->GetClass()->GetName());
+        return;
     }
-    return ServeJson(Result, R);
+    const bool bCreated = !Texture;
+    if (bCreated) {
+        Texture = NewObject<UTexture2D>(Package, *Name, RF_Public | RF_Standalone | RF_Transactional);
+
+        // 新規作成時はファクトリと同じ既定値にする。上書きの場合は既存の設定を残す (ファクトリと同じ)
+        const UTextureFactory* Factory = GetDefault<UTextureFactory>();
+        const bool bGray = Item.SourceFormat == TSF_G8 || Item.SourceFormat == TSF_G16;
+        Texture->SRGB = Item.SourceFormat == TSF_BGRA8 || Item.SourceFormat == TSF_G8;
+        Texture->CompressionSettings = bGray && Factory->CompressionSettings == TC_Default ? TC_Grayscale : Factory->CompressionSettings;
+        Texture->CompressionNone = Factory->NoCompression;
+        Texture->CompressionNoAlpha = Factory->NoAlpha;
+        Texture->DeferCompression = Factory->bDeferCompression;
+        Texture->MipGenSettings = Factory->MipGenSettings;
+        Texture->LODGroup = Factory->LODGroup;
+    }
+    else {
+        Texture->PreEditChange(nullptr);
+    }
+    Texture->Source.Init(Item.Width, Item.Height, 1, 1, Item.SourceFormat, Item.Pixels.GetData());
+    if (Texture->AssetImportData) {
+        Texture->AssetImportData->Update(Item.File);
+    }
+    Texture->PostEditChange();
+    Package->MarkPackageDirty();
+    if (bCreated) {
+        FAssetRegistryModule::AssetCreated(Texture);
+    }
+
+    Item.Objects.Add(Texture->GetPathName());
+    Item.bOk = true;
 }
 
-bool FHTTPLinkModule::OnActorFocus(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
+// テクスチャ以外 (FBX など) はファクトリでインポートする
+static void CommitWithFactory(FAssetImportItem& Item)
 {
-    bool R = false;
-    TFunction<AActor* ()> Finder = GetActorFinder(Request);
-
-    if (Finder) {
-        // アニメーションを見せるため Unreal Editor を最前面化
-        MakeEditorWindowForeground();
+    UAssetImportTask* Task = NewObject<UAssetImportTask>();
+    Task->Filename = Item.File;
+    Task->DestinationPath = Item.Destination;
+    Task->bAutomated = true;
+    Task->bReplaceExisting = true;
+    Task->bSave = false;
 
-        GEditor->SelectNone(true, false);
-        if (AActor* Actor = Finder()) {
-            GEditor->SelectActor(Actor, true, true, true);
+    IAssetTools& AssetTools = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools").Get();
+    AssetTools.ImportAssetTasks({ Task });
 
-            // Actor をフォーカス (F キーと同等の操作)
-            GUnrealEd->Exec(GetEditorWorld(), TEXT("CAMERA ALIGN ACTIVEVIEWPORTONLY"));
-            R = true;
-        }
+    Item.Objects = Task->ImportedObjectPaths;
+    Item.bOk = Item.Objects.Num() > 0;
+    if (!Item.bOk) {
+        Item.Error = TEXT("import failed");
     }
-    return ServeJson(Result, R);
 }
 
-bool FHTTPLinkModule::OnActorCreate(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
+// /asset/import
+// 同じ場所にインポート:     { "files": ["C:/src/a.fbx", "C:/src/b.png"], "destination": "/Game/Imported" }
+// ファイルごとに場所を指定: { "items": [ { "file": ..., "destination": ... }, ... ] }
+// async=true の場合はジョブ ID を返し、結果は /job/status で確認する
+bool FHTTPLinkModule::OnAssetImport(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
 {
-    if (!GEditor) {
-        return Serve(Result);
-    }
-
-    FString Label;
-    FVector Location = FVector::Zero();
-    FString AssetPath;
-    FString ClassName; // 接辞語を除いた class 名 (例: "Actor", "StaticMeshActor", etc)
+    TArray<FString> Files;
+    FString File;
+    FString Destination = TEXT("/Game/Imported");
+    TArray<TSharedPtr<FJsonValue>> Items;
+    bool RunAsync = false;
     GetQueryParams(Request, {
-        { "label", Label }, { "location", Location }, { "assetPath", AssetPath}, { "className", ClassName}
+        { "files", Files }, { "file", File }, { "destination", Destination }, { "items", Items }, { "async", RunAsync },
         });
+    if (!File.IsEmpty()) {
+        Files.Add(File);
+    }
 
-    AActor* Actor = nullptr;
-    auto SpawnActorScope = [&](auto&& SpawnActor) {
-        auto UndoScope = FScopedTransaction(LOCTEXT("OnCreateActor", "OnCreateActor"));
-        Actor = SpawnActor();
-        if (Actor && !Label.IsEmpty()) {
-            Actor->SetActorLabel(Label);
+    struct FState
+    {
+        TArray<FAssetImportItem> Items;
+        double StartTime = 0.0;
+
+        // デコードは Items の要素を直接書き換えるので、ジョブが途中で破棄された場合 (終了時など) も完了を待ってから解放する
+        ~FState()
+        {
+            for (auto& Item : Items) {
+                if (Item.Decode.IsValid()) {
+                    Item.Decode.Wait();
+                }
+            }
         }
     };
-
-    if (!AssetPath.IsEmpty()) {
-        FAssetData AssetData = GetAssetByObjectPath(AssetPath);
-        if (AssetData.IsValid()) {
-            SpawnActorScope([&]() {
-                return GetEditorActorSubsystem()->SpawnActorFromObject(AssetData.GetAsset(), Location);
-                });
+    auto State = MakeShared<FState>();
+    State->StartTime = FPlatformTime::Seconds();
+    for (auto& F : Files) {
+        auto& Item = State->Items.AddDefaulted_GetRef();
+        Item.File = F;
+        Item.Destination = Destination;
+    }
+    for (auto& V : Items) {
+        TSharedPtr<FJsonObject>* Obj;
+        if (V->TryGetObject(Obj)) {
+            auto& Item = State->Items.AddDefaulted_GetRef();
+            Item.File = (*Obj)->GetStringField(TEXT("file"));
+            if (!(*Obj)->TryGetStringField(TEXT("destination"), Item.Destination)) {
+                Item.Destination = Destination;
+            }
         }
     }
-    else if (!ClassName.IsEmpty()) {
-        if (UClass* C = FEditorClassUtils::GetClassFromString(ClassName)) {
-            SpawnActorScope([&]() {
-                return GetEditorActorSubsystem()->SpawnActorFromClass(C, Location);
-                });
+    if (State->Items.IsEmpty()) {
+        return ServeJson(Result, false);
+    }
+
+    // クライアントが指定したインポート先は、パッケージを作る前にここで検証しておく
+    for (auto& Item : State->Items) {
+        if (!FPackageName::IsValidLongPackageName(Item.Destination)) {
+            Item.Error = FString::Printf(TEXT("invalid destination: %s"), *Item.Destination);
+            Item.bCommitted = true;
         }
     }
 
-    JObject Json;
-    Json["result"] = Actor ? true : false;
-    if (Actor) {
-        Json["actor"] = MakeActorSummary(Actor);
+    // 画像のデコードを並列に開始
+    // モジュールのロードはゲームスレッドで済ませておく
+    auto& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
+    for (auto& Item : State->Items) {
+        Item.bTexture = IsImageFile(Item.File);
+        if (Item.bTexture && !Item.bCommitted) {
+            Item.Decode = Async(EAsyncExecution::ThreadPool, [&ImageWrapperModule, &Item]() { DecodeImageFile(ImageWrapperModule, Item); });
+        }
     }
-    return ServeJson(Result, MoveTemp(Json));
-}
 
-bool FHTTPLinkModule::OnActorDelete(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
-{
-    bool R = false;
-    TFunction<AActor* ()> Finder = GetActorFinder(Request);
+    // デコードが終わったものから順に、1 tick あたりの時間を区切ってゲームスレッドでコミットしていく
+    auto Step = [State](FJob& Job) {
+        const double Deadline = FPlatformTime::Seconds() + 0.1;
+        int32 NumCommitted = 0;
+        Job.Phase = TEXT("import");
+        for (auto& Item : State->Items) {
+            if (!Item.bCommitted && Item.IsReady() && FPlatformTime::Seconds() < Deadline) {
+                const double Begin = FPlatformTime::Seconds();
+                if (Item.bTexture) {
+                    CommitTexture(Item);
+                }
+                else {
+                    CommitWithFactory(Item);
+                }
+                Item.Pixels.Empty();
+                Item.CommitTime = FPlatformTime::Seconds() - Begin;
+                Item.bCommitted = true;
+            }
+            if (Item.bCommitted) {
+                ++NumCommitted;
+            }
+        }
+        Job.Progress = (float)NumCommitted / State->Items.Num();
+        if (NumCommitted < State->Items.Num()) {
+            return false;
+        }
 
-    if (Finder) {
-        if (AActor* Actor = Finder()) {
-            auto UndoScope = FScopedTransaction(LOCTEXT("OnDeleteActor", "OnDeleteActor"));
-            Actor->Modify();
-            Actor->Destroy();
-            R = true;
+        bool Ok = true;
+        JArray Json;
+        for (auto& Item : State->Items) {
+            Ok &= Item.bOk;
+            Json.Add(Item.ToJson());
         }
+        Job.Result = JObject({
+            { "result", Ok },
+            { "files", Json },
+            { "elapsed", FPlatformTime::Seconds() - State->StartTime },
+            });
+        return Ok ? true : Job.Fail(TEXT("failed to import some files"));
+    };
+
+    if (RunAsync) {
+        return ServeJson(Result, MakeJobStarted(StartJob(TEXT("asset/import"), MoveTemp(Step))->Id));
     }
-    return ServeJson(Result, R);
-}
 
-bool FHTTPLinkModule::OnActorMerge(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
-{
-    // todo
-    return ServeJson(Result, false);
+    FJob Job;
+    for (auto& Item : State->Items) {
+        if (Item.Decode.IsValid()) {
+            Item.Decode.Wait();
+        }
+    }
+    while (!Step(Job)) {
+    }
+    return ServeJson(Result, MoveTemp(Job.Result));
 }
+#pragma endregion Asset Commands
 
-bool FHTTPLinkModule::OnActorTransform(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
+
+#pragma region Upload Commands
+// アップロードされたデータ
+// しきい値を超えるまではメモリ上に置き、超えたら一時ファイルに書き出す。finish 後は一時ファイルをメモリマップして参照する。
+// どちらの場合も、他のコマンドには upload=<id>(&part=<name>) でコピーせずにリクエストボディとして渡せる
+struct FHTTPLinkModule::FUpload
 {
-    bool R = false;
-    AActor* Target = nullptr;
-    if (auto Finder = GetActorFinder(Request)) {
-        Target = Finder();
+    struct FPart
+    {
+        FString Name;
+        FString FileName;
+        FString ContentType;
+        int64 Offset = 0;
+        int64 Size = 0;
+    };
+
+    FString Id;
+    int64 Size = 0;
+    bool bFinished = false;
+    double LastAccess = 0.0;
+    TArray<FPart> Parts;
+
+    TArray<uint8> Memory;
+    FString TempFile;
+    TUniquePtr<IFileHandle> Writer;
+    TUniquePtr<IMappedFileHandle> MappedFile;
+    TUniquePtr<IMappedFileRegion> MappedRegion;
+
+    ~FUpload()
+    {
+        MappedRegion.Reset();
+        MappedFile.Reset();
+        Writer.Reset();
+        if (!TempFile.IsEmpty()) {
+            IFileManager::Get().Delete(*TempFile, false, true, true);
+        }
     }
-    if (Target) {
-        FVector Translation;
-        FQuat Rotation;
-        FVector Scale;
-        bool Absolute = true;
-        auto Set = GetQueryParams(Request, {
-            { "t", Translation }, { "r", Rotation }, { "s", Scale}, { "abs", Absolute},
-            });
 
-        if (Set.Contains("s")) {
-            if (!Absolute) {
-                Scale = Target->GetActorScale() * Scale;
-            }
-            Target->SetActorScale3D(Scale);
-            R = true;
+    bool Append(TArrayView64<const uint8> Data, int64 SpillThreshold)
+    {
+        if (bFinished) {
+            return false;
         }
-        if (Set.Contains("r")) {
-            if (!Absolute) {
-                Rotation = Target->GetActorRotation().Quaternion() * Rotation;
+        if (!Writer && Size + Data.Num() > SpillThreshold) {
+            // 一時ファイルに切り替え
+            TempFile = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir() / TEXT("HTTPLink/Uploads") / Id + TEXT(".bin"));
+            IFileManager::Get().MakeDirectory(*FPaths::GetPath(TempFile), true);
+            Writer.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*TempFile));
+            if (!Writer || !Writer->Write(Memory.GetData(), Memory.Num())) {
+                return false;
             }
-            Target->SetActorRotation(Rotation);
-            R = true;
+            Memory.Empty();
         }
-        if (Set.Contains("t")) {
-            if (!Absolute) {
-                Translation = Target->GetActorLocation() + Translation;
+
+        if (Writer) {
+            if (!Writer->Write(Data.GetData(), Data.Num())) {
+                return false;
             }
-            Target->SetActorLocation(Translation);
-            R = true;
         }
+        else {
+            Memory.Append(Data.GetData(), Data.Num());
+        }
+        Size += Data.Num();
+        return true;
     }
-    return ServeJson(Result, R);
-}
-#pragma endregion Actor Commands
 
+    bool Finish(const FString& ContentType)
+    {
+        if (bFinished) {
+            return true;
+        }
+        if (Writer) {
+            Writer.Reset();
+            MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*TempFile));
+            MappedRegion.Reset(MappedFile ? MappedFile->MapRegion(0, Size) : nullptr);
+            if (!MappedRegion) {
+                return false;
+            }
+        }
+        bFinished = true;
 
-#pragma region Level Commands
-bool FHTTPLinkModule::OnLevelNew(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
-{
-    if (!GEditor) {
-        return ServeJson(Result, false);
+        FString Boundary;
+        if (ContentType.StartsWith(TEXT("multipart/")) && ContentType.Split(TEXT("boundary="), nullptr, &Boundary)) {
+            Boundary.TrimQuotesInline();
+            ParseMultipart(Boundary);
+        }
+        return true;
     }
 
-    bool R = false;
-    FString AssetPath, TemplatePath;
-    GetQueryParams(Request, {
-        { "assetpath", AssetPath }, { "templatepath", TemplatePath}
-        });
+    TArrayView64<const uint8> GetView() const
+    {
+        if (MappedRegion) {
+            return TArrayView64<const uint8>(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+        }
+        return TArrayView64<const uint8>(Memory.GetData(), Memory.Num());
+    }
 
-    if (!AssetPath.IsEmpty()) {
-        auto LevelEditorSubsystem = GEditor->GetEditorSubsystem<ULevelEditorSubsystem>();
-        if (!TemplatePath.IsEmpty()) {
-            R = LevelEditorSubsystem->NewLevelFromTemplate(AssetPath, TemplatePath);
+    // Part は名前か番号で指定
+    bool GetPartView(const FString& Part, TArrayView64<const uint8>& Dst) const
+    {
+        const FPart* Found = Parts.FindByPredicate([&](const FPart& P) { return P.Name == Part; });
+        if (!Found && Part.IsNumeric()) {
+            int32 Index = FCString::Atoi(*Part);
+            Found = Parts.IsValidIndex(Index) ? &Parts[Index] : nullptr;
         }
-        else {
-            R = LevelEditorSubsystem->NewLevel(AssetPath);
+        if (!Found) {
+            return false;
         }
+        Dst = GetView().Slice(Found->Offset, Found->Size);
+        return true;
     }
-    return ServeJson(Result, R);
-}
 
-bool FHTTPLinkModule::OnLevelLoad(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
-{
-    if (!GEditor) {
-        return ServeJson(Result, false);
+    static int64 Find(TArrayView64<const uint8> Data, int64 From, const FAnsiStringView& Pattern)
+    {
+        const int64 Last = Data.Num() - Pattern.Len();
+        for (int64 I = From; I <= Last; ++I) {
+            if (Data[I] == (uint8)Pattern[0] && FMemory::Memcmp(&Data[I], Pattern.GetData(), Pattern.Len()) == 0) {
+                return I;
+            }
+        }
+        return INDEX_NONE;
     }
 
-    bool R = false;
-    FString AssetPath;
-    GetQueryParams(Request, {
-        { "assetpath", AssetPath },
-        });
+    // パートはデータを指すオフセットとサイズとして記録する。ヘッダ以外はコピーしない
+    void ParseMultipart(const FString& Boundary)
+    {
+        const TArrayView64<const uint8> Data = GetView();
+        const FString DelimiterStr = TEXT("--") + Boundary;
+        const auto Delimiter = StringCast<ANSICHAR>(*DelimiterStr);
+        const FAnsiStringView Delim(Delimiter.Get(), Delimiter.Length());
+        const FAnsiStringView HeaderEnd("\r\n\r\n");
 
-    if (!AssetPath.IsEmpty()) {
-        auto LevelEditorSubsystem = GEditor->GetEditorSubsystem<ULevelEditorSubsystem>();
-        R = LevelEditorSubsystem->LoadLevel(AssetPath);
+        int64 Pos = Find(Data, 0, Delim);
+        while (Pos != INDEX_NONE) {
+            Pos += Delim.Len();
+            // 終端の "--boundary--"
+            if (Pos + 2 <= Data.Num() && Data[Pos] == '-' && Data[Pos + 1] == '-') {
+                break;
+            }
+            const int64 HeaderBegin = Pos + 2; // skip CRLF
+            const int64 HeaderLast = Find(Data, HeaderBegin, HeaderEnd);
+            if (HeaderLast == INDEX_NONE) {
+                break;
+            }
+            const int64 PartBegin = HeaderLast + HeaderEnd.Len();
+            const int64 Next = Find(Data, PartBegin, Delim);
+            if (Next == INDEX_NONE) {
+                break;
+            }
+
+            FPart Part;
+            Part.Offset = PartBegin;
+            Part.Size = FMath::Max<int64>(Next - 2 - PartBegin, 0); // 区切りの前の CRLF は含まない
+
+            FString Headers(FUTF8ToTCHAR((const ANSICHAR*)&Data[HeaderBegin], (int32)(HeaderLast - HeaderBegin)));
+            TArray<FString> Lines;
+            Headers.ParseIntoArrayLines(Lines);
+            for (auto& Line : Lines) {
+                FString Key, Value;
+                if (!Line.Split(TEXT(":"), &Key, &Value)) {
+                    continue;
+                }
+                Value.TrimStartAndEndInline();
+                if (Key == TEXT("Content-Type")) {
+                    Part.ContentType = Value;
+                }
+                else if (Key == TEXT("Content-Disposition")) {
+                    TArray<FString> Fields;
+                    Value.ParseIntoArray(Fields, TEXT(";"));
+                    for (auto& Field : Fields) {
+                        FString FieldKey, FieldValue;
+                        if (Field.Split(TEXT("="), &FieldKey, &FieldValue)) {
+                            FieldKey.TrimStartAndEndInline();
+                            FieldValue.TrimQuotesInline();
+                            if (FieldKey == TEXT("name")) {
+                                Part.Name = FieldValue;
+                            }
+                            else if (FieldKey == TEXT("filename")) {
+                                Part.FileName = FieldValue;
+                            }
+                        }
+                    }
+                }
+            }
+            Parts.Add(MoveTemp(Part));
+            Pos = Next;
+        }
     }
-    return ServeJson(Result, R);
-}
 
-bool FHTTPLinkModule::OnLevelSave(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
+    JObject ToJson() const
+    {
+        JArray PartsJson;
+        for (auto& P : Parts) {
+            PartsJson.Add(JObject({
+                { "name", P.Name },
+                { "filename", P.FileName },
+                { "contentType", P.ContentType },
+                { "offset", P.Offset },
+                { "size", P.Size },
+                }));
+        }
+        return JObject({
+            { "result", true },
+            { "id", Id },
+            { "size", Size },
+            { "finished", bFinished },
+            { "mapped", MappedRegion.IsValid() },
+            { "parts", PartsJson },
+            });
+    }
+};
+
+FHTTPLinkModule::FUpload* FHTTPLinkModule::FindUpload(const FString& Id)
 {
-    if (!GEditor) {
-        return ServeJson(Result, false);
+    // 放置されたアップロードはここで破棄する
+    const double Now = FPlatformTime::Seconds();
+    for (auto It = Uploads.CreateIterator(); It; ++It) {
+        if (Now - It->Value->LastAccess > UploadExpireSeconds) {
+            It.RemoveCurrent();
+        }
     }
 
-    bool R = false;
-    bool All = false;
-    GetQueryParams(Request, {
-        { "all", All },
-        });
+    if (auto* Found = Uploads.Find(Id)) {
+        (*Found)->LastAccess = Now;
+        return Found->Get();
+    }
+    return nullptr;
+}
 
-    auto LevelEditorSubsystem = GEditor->GetEditorSubsystem<ULevelEditorSubsystem>();
-    if (All) {
-        R = LevelEditorSubsystem->SaveAllDirtyLevels();
+FHTTPLinkModule::FUpload& FHTTPLinkModule::NewUpload()
+{
+    auto Upload = MakeShared<FUpload>();
+    Upload->Id = FGuid::NewGuid().ToString(EGuidFormats::Digits);
+    Upload->LastAccess = FPlatformTime::Seconds();
+    Uploads.Add(Upload->Id, Upload);
+    return *Upload;
+}
+
+bool FHTTPLinkModule::ResolveUploadBody(const FHTTPLinkRequest& Request, TArrayView64<const uint8>& Dst)
+{
+    auto* Id = Request.QueryParams.Find(TEXT("upload"));
+    FUpload* Upload = Id ? FindUpload(*Id) : nullptr;
+    if (!Upload || !Upload->bFinished) {
+        return false;
     }
-    else {
-        R = LevelEditorSubsystem->SaveCurrentLevel();
+    if (auto* Part = Request.QueryParams.Find(TEXT("part"))) {
+        return Upload->GetPartView(*Part, Dst);
     }
-    return ServeJson(Result, R);
+    Dst = Upload->GetView();
+    return true;
 }
-#pragma endregion Level Commands
 
+// POST /upload
+// ボディをそのままアップロードとして保存する。Content-Type が multipart の場合はパートに分解する
+bool FHTTPLinkModule::OnUpload(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    FUpload& Upload = NewUpload();
+    if (!Upload.Append(Request.Body, UploadSpillThreshold) || !Upload.Finish(Request.ContentType)) {
+        FString Id = Upload.Id;
+        Uploads.Remove(Id);
+        return ServeJson(Result, false);
+    }
+    return ServeJson(Result, Upload.ToJson());
+}
 
-#pragma region Asset Commands
-static JObject MakeAssetSummary(const FAssetData& Data)
+// POST /upload/begin
+// 分割アップロードの開始。以降 /upload/append?id=... でボディを追記し、/upload/finish?id=... で完了する
+bool FHTTPLinkModule::OnUploadBegin(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
 {
-    return JObject({
-        { "typeName", Data.GetClass()->GetName() },
-        { "assetName", Data.AssetName },
-        { "packageName", Data.PackageName },
-        { "objectPath", GetObectPathStr(Data) },
+    return ServeJson(Result, NewUpload().ToJson());
+}
+
+bool FHTTPLinkModule::OnUploadAppend(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
+{
+    FString Id;
+    GetQueryParams(Request, {
+        { "id", Id },
         });
+    FUpload* Upload = FindUpload(Id);
+    if (!Upload || !Upload->Append(Request.Body, UploadSpillThreshold)) {
+        return ServeJson(Result, false);
+    }
+    return ServeJson(Result, Upload->ToJson());
 }
 
-bool FHTTPLinkModule::OnAssetList(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
+// /upload/finish?id=...&contentType=multipart/form-data; boundary=...
+bool FHTTPLinkModule::OnUploadFinish(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
 {
-    JArray Json;
-    auto& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-    AssetRegistryModule.Get().EnumerateAllAssets([&](const FAssetData& Data) {
-        Json.Add(MakeAssetSummary(Data));
-        return true;
+    FString Id, ContentType;
+    GetQueryParams(Request, {
+        { "id", Id }, { "contentType", ContentType },
         });
-    return ServeJson(Result, MoveTemp(Json));
+    FUpload* Upload = FindUpload(Id);
+    if (!Upload || !Upload->Finish(ContentType)) {
+        return ServeJson(Result, false);
+    }
+    return ServeJson(Result, Upload->ToJson());
 }
 
-bool FHTTPLinkModule::OnAssetImport(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
+bool FHTTPLinkModule::OnUploadDelete(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
 {
-    // todo
-    return ServeJson(Result, false);
+    FString Id;
+    GetQueryParams(Request, {
+        { "id", Id },
+        });
+    return ServeJson(Result, Uploads.Remove(Id) > 0);
 }
-#pragma endregion Asset Commands
+#pragma endregion Upload Commands
 
 
 #pragma region Test Commands
-bool FHTTPLinkModule::OnTest(const FHttpServerRequest& Request, const FHttpResultCallback& Result)
+bool FHTTPLinkModule::OnTest(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)
 {
 #if (UE_BUILD_DEBUG || UE_BUILD_DEVELOPMENT || UE_BUILD_TEST)
     FString Case;
@@ -942,8 +5081,6 @@ bool FHTTPLinkModule::OnTest(const FHttpServerRequest& Request, const FHttpResul
         }
         return ServeJson(Result, MoveTemp(Json));
     }
-    else {
-    }
 #endif
 
     return ServeJson(Result, false);
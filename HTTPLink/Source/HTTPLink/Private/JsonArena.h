@@ -0,0 +1,507 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+
+
+// Arena-backed JSON DOM for large responses.
+// FJsonObject / FJsonValue allocate every value separately on the heap with a refcount, which means millions of
+// small allocations and frees for a big listing. FJsonArenaDocument bump-allocates all values, strings and
+// containers from blocks it owns and releases them in one shot when the document is destroyed.
+//   auto Doc = MakeShared<FJsonArenaDocument>();
+//   FJsonArenaValue* Root = Doc->MakeArray();
+//   FJsonArenaValue* Item = Doc->MakeObject();
+//   Doc->Set(Item, "name", Doc->MakeString(Name));
+//   Doc->Add(Root, Item);
+//   Doc->SetRoot(Root);
+// Make() converts C++ values the way JObject::ToJValue() (JsonUtils.h) does, so handlers can build the same output
+// without going through FJsonValue:
+//   Doc->Add(Root, Doc->MakeObject({ { "name", Doc->Make(Actor->GetFName()) }, { "transform", Doc->Make(Transform) } }));
+// The document serializes itself straight to UTF-8 (Write()) and can be converted to FJsonValue for code that
+// expects the regular DOM (ToJsonValue()).
+// Values are plain data and are never destructed individually. A document must only be used from one thread.
+
+class FJsonArena
+{
+public:
+    static constexpr SIZE_T DefaultBlockSize = 64 * 1024;
+
+    FJsonArena() = default;
+    FJsonArena(const FJsonArena&) = delete;
+    FJsonArena& operator=(const FJsonArena&) = delete;
+    ~FJsonArena() { Reset(); }
+
+    void* Allocate(SIZE_T Size, SIZE_T Alignment = alignof(double))
+    {
+        uint8* P = Align(Cursor, Alignment);
+        if (!Cursor || P + Size > End) {
+            // oversized requests get a dedicated block so they don't waste the rest of the current one
+            SIZE_T BlockSize = FMath::Max(DefaultBlockSize, Size + Alignment);
+            uint8* Block = (uint8*)FMemory::Malloc(BlockSize);
+            Blocks.Add(Block);
+            TotalReserved += BlockSize;
+            if (Size + Alignment > DefaultBlockSize / 2) {
+                return Align(Block, Alignment);
+            }
+            Cursor = Block;
+            End = Block + BlockSize;
+            P = Align(Cursor, Alignment);
+        }
+        Cursor = P + Size;
+        return P;
+    }
+
+    template<class T>
+    T* AllocateArray(int32 Num)
+    {
+        static_assert(TIsTriviallyDestructible<T>::Value, "arena memory is released without running destructors");
+        return (T*)Allocate(sizeof(T) * FMath::Max(Num, 1), alignof(T));
+    }
+
+    void Reset()
+    {
+        for (uint8* Block : Blocks) {
+            FMemory::Free(Block);
+        }
+        Blocks.Reset();
+        Cursor = End = nullptr;
+        TotalReserved = 0;
+    }
+
+    SIZE_T GetReservedSize() const { return TotalReserved; }
+
+private:
+    static uint8* Align(uint8* P, SIZE_T Alignment)
+    {
+        return (uint8*)(((UPTRINT)P + (Alignment - 1)) & ~(UPTRINT)(Alignment - 1));
+    }
+
+    TArray<uint8*> Blocks;
+    uint8* Cursor = nullptr;
+    uint8* End = nullptr;
+    SIZE_T TotalReserved = 0;
+};
+
+
+struct FJsonArenaValue;
+class FJsonArenaDocument;
+
+// Customization point for FJsonArenaDocument::Make(), the arena counterpart of ToJsonValue in JsonUtils.h.
+//   template<> struct ToJsonArenaValue<FMyType>
+//   {
+//       FJsonArenaValue* operator()(FJsonArenaDocument& Doc, const FMyType& Value) const;
+//   };
+template<class T> struct ToJsonArenaValue {};
+
+namespace JsonArenaDetail
+{
+    template<class T, class = void>
+    struct THasToJsonArenaValue : std::false_type {};
+    template<class T>
+    struct THasToJsonArenaValue<T, std::void_t<decltype(std::declval<ToJsonArenaValue<T>>()(std::declval<FJsonArenaDocument&>(), std::declval<const T&>()))>> : std::true_type {};
+
+    template<class T, class = void>
+    struct TIsRange : std::false_type {};
+    template<class T>
+    struct TIsRange<T, std::void_t<decltype(std::begin(std::declval<const T&>())), decltype(std::declval<const T&>().Num())>> : std::true_type {};
+}
+
+struct FJsonArenaString
+{
+    const UTF8CHAR* Data;
+    int32 Len;
+};
+
+struct FJsonArenaField
+{
+    FJsonArenaString Key;
+    FJsonArenaValue* Value;
+};
+
+struct FJsonArenaValue
+{
+    enum class EType : uint8
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    struct FContainer
+    {
+        // FJsonArenaValue* for arrays, FJsonArenaField for objects
+        void* Items;
+        int32 Num;
+        int32 Capacity;
+    };
+
+    EType Type = EType::Null;
+    union
+    {
+        bool Bool;
+        double Number;
+        FJsonArenaString String;
+        FContainer Container;
+    };
+
+    FJsonArenaValue() : Number(0.0) {}
+
+    TArrayView<FJsonArenaValue* const> GetItems() const { return { (FJsonArenaValue* const*)Container.Items, Container.Num }; }
+    TArrayView<const FJsonArenaField> GetFields() const { return { (const FJsonArenaField*)Container.Items, Container.Num }; }
+};
+
+
+class FJsonArenaDocument
+{
+public:
+    FJsonArenaDocument() = default;
+    FJsonArenaDocument(const FJsonArenaDocument&) = delete;
+    FJsonArenaDocument& operator=(const FJsonArenaDocument&) = delete;
+
+#pragma region Build
+    FJsonArenaValue* MakeNull() { return New(FJsonArenaValue::EType::Null); }
+
+    FJsonArenaValue* MakeBool(bool V)
+    {
+        FJsonArenaValue* Ret = New(FJsonArenaValue::EType::Bool);
+        Ret->Bool = V;
+        return Ret;
+    }
+
+    FJsonArenaValue* MakeNumber(double V)
+    {
+        FJsonArenaValue* Ret = New(FJsonArenaValue::EType::Number);
+        Ret->Number = V;
+        return Ret;
+    }
+
+    FJsonArenaValue* MakeString(const TCHAR* Str, int32 Len)
+    {
+        FJsonArenaValue* Ret = New(FJsonArenaValue::EType::String);
+        Ret->String = CopyString(Str, Len);
+        return Ret;
+    }
+    FJsonArenaValue* MakeString(const TCHAR* Str) { return MakeString(Str, FCString::Strlen(Str)); }
+    FJsonArenaValue* MakeString(const FString& Str) { return MakeString(*Str, Str.Len()); }
+    FJsonArenaValue* MakeString(FName Name)
+    {
+        FNameBuilder Builder(Name);
+        return MakeString(Builder.GetData(), Builder.Len());
+    }
+
+    // Capacity is only a hint; containers grow by doubling inside the arena
+    FJsonArenaValue* MakeArray(int32 Capacity = 0) { return NewContainer<FJsonArenaValue*>(FJsonArenaValue::EType::Array, Capacity); }
+    FJsonArenaValue* MakeObject(int32 Capacity = 0) { return NewContainer<FJsonArenaField>(FJsonArenaValue::EType::Object, Capacity); }
+
+    struct FField
+    {
+        const ANSICHAR* Key;
+        FJsonArenaValue* Value;
+    };
+    // Doc.MakeObject({ { "x", Doc.MakeNumber(1) }, { "name", Doc.Make(Name) } })
+    FJsonArenaValue* MakeObject(std::initializer_list<FField> Fields)
+    {
+        FJsonArenaValue* Ret = MakeObject((int32)Fields.size());
+        for (const FField& F : Fields) {
+            Set(Ret, F.Key, F.Value);
+        }
+        return Ret;
+    }
+
+    void Add(FJsonArenaValue* Array, FJsonArenaValue* Value)
+    {
+        check(Array->Type == FJsonArenaValue::EType::Array);
+        Push<FJsonArenaValue*>(Array, Value);
+    }
+
+    // Key is ASCII (field names are always literals in practice) and copied into the arena
+    void Set(FJsonArenaValue* Object, const ANSICHAR* Key, FJsonArenaValue* Value)
+    {
+        check(Object->Type == FJsonArenaValue::EType::Object);
+        Push<FJsonArenaField>(Object, FJsonArenaField{ CopyKey(Key), Value });
+    }
+
+    // Same rules as JObject::ToJValue() for the types it covers: bool, numbers and enums, strings and names, FGuid,
+    // math types (same shape as FJsonObjectConverter) and ranges of those. Other types can specialize ToJsonArenaValue.
+    template<class T>
+    FJsonArenaValue* Make(const T& Value)
+    {
+        if constexpr (std::is_same_v<T, FJsonArenaValue*>) {
+            return Value;
+        }
+        else if constexpr (JsonArenaDetail::THasToJsonArenaValue<T>::value) {
+            return ToJsonArenaValue<T>()(*this, Value);
+        }
+        else if constexpr (std::is_same_v<T, bool>) {
+            return MakeBool(Value);
+        }
+        else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+            return MakeNumber((double)Value);
+        }
+        else if constexpr (std::is_same_v<T, FString> || std::is_same_v<T, FName> || std::is_convertible_v<const T&, const TCHAR*>) {
+            return MakeString(Value);
+        }
+        else if constexpr (std::is_same_v<T, FGuid>) {
+            // FGuid::ToString() (EGuidFormats::Digits) without the temporary FString
+            ANSICHAR Buf[33];
+            const int32 Len = FCStringAnsi::Snprintf(Buf, sizeof(Buf), "%08X%08X%08X%08X", Value.A, Value.B, Value.C, Value.D);
+            FJsonArenaValue* Ret = New(FJsonArenaValue::EType::String);
+            Ret->String = CopyAscii(Buf, Len);
+            return Ret;
+        }
+        else if constexpr (std::is_same_v<T, FVector>) {
+            return MakeObject({ { "x", MakeNumber(Value.X) }, { "y", MakeNumber(Value.Y) }, { "z", MakeNumber(Value.Z) } });
+        }
+        else if constexpr (std::is_same_v<T, FQuat>) {
+            return MakeObject({ { "x", MakeNumber(Value.X) }, { "y", MakeNumber(Value.Y) }, { "z", MakeNumber(Value.Z) }, { "w", MakeNumber(Value.W) } });
+        }
+        else if constexpr (std::is_same_v<T, FRotator>) {
+            return MakeObject({ { "pitch", MakeNumber(Value.Pitch) }, { "yaw", MakeNumber(Value.Yaw) }, { "roll", MakeNumber(Value.Roll) } });
+        }
+        else if constexpr (std::is_same_v<T, FTransform>) {
+            return MakeObject({
+                { "rotation", Make(Value.GetRotation()) },
+                { "translation", Make(Value.GetTranslation()) },
+                { "scale3D", Make(Value.GetScale3D()) },
+                });
+        }
+        else if constexpr (JsonArenaDetail::TIsRange<T>::value) {
+            FJsonArenaValue* Ret = MakeArray(Value.Num());
+            for (const auto& E : Value) {
+                Add(Ret, Make(E));
+            }
+            return Ret;
+        }
+        else {
+            static_assert(sizeof(T) == 0, "no arena conversion for this type. specialize ToJsonArenaValue.");
+            return nullptr;
+        }
+    }
+
+    void SetRoot(FJsonArenaValue* Value) { Root = Value; }
+    FJsonArenaValue* GetRoot() const { return Root; }
+    SIZE_T GetArenaSize() const { return Arena.GetReservedSize(); }
+#pragma endregion Build
+
+
+#pragma region Output
+    // compact (not pretty-printed) UTF-8
+    TArray<uint8> Write() const
+    {
+        TArray<uint8> Ret;
+        // the arena size is a decent guess for the output size
+        Ret.Reserve((int32)FMath::Min<SIZE_T>(Arena.GetReservedSize(), 256 * 1024 * 1024));
+        if (Root) {
+            Write(Ret, *Root);
+        }
+        return Ret;
+    }
+
+    TSharedPtr<FJsonValue> ToJsonValue() const
+    {
+        return Root ? ToJsonValue(*Root) : MakeShared<FJsonValueNull>();
+    }
+
+    static TSharedPtr<FJsonValue> ToJsonValue(const FJsonArenaValue& V)
+    {
+        switch (V.Type) {
+        case FJsonArenaValue::EType::Bool:
+            return MakeShared<FJsonValueBoolean>(V.Bool);
+        case FJsonArenaValue::EType::Number:
+            return MakeShared<FJsonValueNumber>(V.Number);
+        case FJsonArenaValue::EType::String:
+            return MakeShared<FJsonValueString>(ToFString(V.String));
+        case FJsonArenaValue::EType::Array:
+        {
+            TArray<TSharedPtr<FJsonValue>> Items;
+            Items.Reserve(V.Container.Num);
+            for (FJsonArenaValue* Item : V.GetItems()) {
+                Items.Add(ToJsonValue(*Item));
+            }
+            return MakeShared<FJsonValueArray>(MoveTemp(Items));
+        }
+        case FJsonArenaValue::EType::Object:
+        {
+            auto Obj = MakeShared<FJsonObject>();
+            for (const FJsonArenaField& Field : V.GetFields()) {
+                Obj->SetField(ToFString(Field.Key), ToJsonValue(*Field.Value));
+            }
+            return MakeShared<FJsonValueObject>(Obj);
+        }
+        default:
+            return MakeShared<FJsonValueNull>();
+        }
+    }
+#pragma endregion Output
+
+private:
+    FJsonArenaValue* New(FJsonArenaValue::EType Type)
+    {
+        FJsonArenaValue* Ret = new (Arena.Allocate(sizeof(FJsonArenaValue), alignof(FJsonArenaValue))) FJsonArenaValue();
+        Ret->Type = Type;
+        return Ret;
+    }
+
+    template<class T>
+    FJsonArenaValue* NewContainer(FJsonArenaValue::EType Type, int32 Capacity)
+    {
+        FJsonArenaValue* Ret = New(Type);
+        Ret->Container.Items = Capacity > 0 ? Arena.AllocateArray<T>(Capacity) : nullptr;
+        Ret->Container.Num = 0;
+        Ret->Container.Capacity = Capacity;
+        return Ret;
+    }
+
+    template<class T>
+    void Push(FJsonArenaValue* Container, const T& Item)
+    {
+        auto& C = Container->Container;
+        if (C.Num == C.Capacity) {
+            // the old storage stays in the arena until the document dies. doubling keeps that waste below 2x.
+            int32 NewCapacity = FMath::Max(C.Capacity * 2, 8);
+            T* NewItems = Arena.AllocateArray<T>(NewCapacity);
+            if (C.Num) {
+                FMemory::Memcpy(NewItems, C.Items, sizeof(T) * C.Num);
+            }
+            C.Items = NewItems;
+            C.Capacity = NewCapacity;
+        }
+        ((T*)C.Items)[C.Num++] = Item;
+    }
+
+    FJsonArenaString CopyString(const TCHAR* Str, int32 Len)
+    {
+        FTCHARToUTF8 Converter(Str, Len);
+        UTF8CHAR* Dst = Arena.AllocateArray<UTF8CHAR>(Converter.Length());
+        FMemory::Memcpy(Dst, Converter.Get(), Converter.Length());
+        return { Dst, Converter.Length() };
+    }
+
+    FJsonArenaString CopyAscii(const ANSICHAR* Str, int32 Len)
+    {
+        UTF8CHAR* Dst = Arena.AllocateArray<UTF8CHAR>(Len);
+        FMemory::Memcpy(Dst, Str, Len);
+        return { Dst, Len };
+    }
+
+    FJsonArenaString CopyKey(const ANSICHAR* Key)
+    {
+        return CopyAscii(Key, FCStringAnsi::Strlen(Key));
+    }
+
+    static FString ToFString(const FJsonArenaString& S)
+    {
+        FUTF8ToTCHAR Converter((const ANSICHAR*)S.Data, S.Len);
+        return FString(Converter.Length(), Converter.Get());
+    }
+
+    static void Append(TArray<uint8>& Dst, const char* Str, int32 Len)
+    {
+        Dst.Append((const uint8*)Str, Len);
+    }
+
+    static void WriteString(TArray<uint8>& Dst, const FJsonArenaString& S)
+    {
+        static const char Hex[] = "0123456789abcdef";
+        Dst.Add('"');
+        const uint8* P = (const uint8*)S.Data;
+        const uint8* E = P + S.Len;
+        const uint8* Run = P;
+        for (; P < E; ++P) {
+            uint8 C = *P;
+            if (C >= 0x20 && C != '"' && C != '\\') {
+                continue;
+            }
+            Dst.Append(Run, (int32)(P - Run));
+            Run = P + 1;
+            switch (C) {
+            case '"':  Append(Dst, "\\\"", 2); break;
+            case '\\': Append(Dst, "\\\\", 2); break;
+            case '\n': Append(Dst, "\\n", 2); break;
+            case '\r': Append(Dst, "\\r", 2); break;
+            case '\t': Append(Dst, "\\t", 2); break;
+            default:
+            {
+                const char Escaped[] = { '\\', 'u', '0', '0', Hex[C >> 4], Hex[C & 15] };
+                Append(Dst, Escaped, 6);
+                break;
+            }
+            }
+        }
+        Dst.Append(Run, (int32)(P - Run));
+        Dst.Add('"');
+    }
+
+    static void WriteNumber(TArray<uint8>& Dst, double V)
+    {
+        ANSICHAR Buf[64];
+        int32 Len;
+        if (!FMath::IsFinite(V)) {
+            // JSON has no representation for inf / nan
+            Append(Dst, "null", 4);
+            return;
+        }
+        else if (V == FMath::FloorToDouble(V) && FMath::Abs(V) < 1e15) {
+            Len = FCStringAnsi::Snprintf(Buf, sizeof(Buf), "%lld", (long long)V);
+        }
+        else {
+            Len = FCStringAnsi::Snprintf(Buf, sizeof(Buf), "%.17g", V);
+        }
+        Append(Dst, Buf, Len);
+    }
+
+    static void Write(TArray<uint8>& Dst, const FJsonArenaValue& V)
+    {
+        switch (V.Type) {
+        case FJsonArenaValue::EType::Bool:
+            V.Bool ? Append(Dst, "true", 4) : Append(Dst, "false", 5);
+            break;
+        case FJsonArenaValue::EType::Number:
+            WriteNumber(Dst, V.Number);
+            break;
+        case FJsonArenaValue::EType::String:
+            WriteString(Dst, V.String);
+            break;
+        case FJsonArenaValue::EType::Array:
+        {
+            Dst.Add('[');
+            bool First = true;
+            for (FJsonArenaValue* Item : V.GetItems()) {
+                if (!First) {
+                    Dst.Add(',');
+                }
+                First = false;
+                Write(Dst, *Item);
+            }
+            Dst.Add(']');
+            break;
+        }
+        case FJsonArenaValue::EType::Object:
+        {
+            Dst.Add('{');
+            bool First = true;
+            for (const FJsonArenaField& Field : V.GetFields()) {
+                if (!First) {
+                    Dst.Add(',');
+                }
+                First = false;
+                WriteString(Dst, Field.Key);
+                Dst.Add(':');
+                Write(Dst, *Field.Value);
+            }
+            Dst.Add('}');
+            break;
+        }
+        default:
+            Append(Dst, "null", 4);
+            break;
+        }
+    }
+
+    FJsonArena Arena;
+    FJsonArenaValue* Root = nullptr;
+};
@@ -11,6 +11,9 @@
 #include "Serialization/JsonTypes.h"
 #include "Serialization/JsonWriter.h"
 #include "JsonObjectConverter.h"
+#include "UObject/UnrealType.h"
+#include "UObject/EnumProperty.h"
+#include "UObject/TextProperty.h"
 #include <string>
 
 
@@ -140,6 +143,7 @@ public:
     DEF_VALUE(IsStruct, HasStaticStruct<T>::Value || IsNoExportStruct<T>::Value);
 
     DEF_VALUE_C(IsIteratable, decltype(std::begin(std::declval<T&>()) != std::end(std::declval<T&>())), true);
+    DEF_VALUE_C(HasNum, decltype(std::declval<const T&>().Num()), true);
     DEF_VALUE_C(IsContainerCanToObject, typename T::KeyType, IsIteratable<T>::Value && CanToString<typename T::KeyType>::Value);
     DEF_VALUE(CanToObject, IsStruct<T>::Value || IsContainerCanToObject<T>::Value);
 
@@ -249,10 +253,13 @@ public:
             // others to Json Array
             else {
                 TArray<TSharedPtr<FJsonValue>> Data;
+                if constexpr (HasNum<T>::Value) {
+                    Data.Reserve(Value.Num());
+                }
                 for (auto& E : Value) {
                     Data.Add(ToJValue(E));
                 }
-                return MakeShared<FJsonValueArray>(Data);
+                return MakeShared<FJsonValueArray>(MoveTemp(Data));
             }
         }
         // all others can convert to string
@@ -261,28 +268,70 @@ public:
         }
     }
 
+    // rvalues: json values, JObject / JArray, strings and container elements are moved instead of copied.
+    // anything that can't benefit from moving falls back to the const& version.
+    template<class T, class = std::enable_if_t<!std::is_lvalue_reference_v<T>>>
+    static TSharedPtr<FJsonValue> ToJValue(T&& Value)
+    {
+        using U = std::remove_cv_t<T>;
+        if constexpr (std::is_const_v<T>) {
+            return ToJValue(static_cast<const U&>(Value));
+        }
+        else if constexpr (std::is_same_v<U, TSharedPtr<FJsonValue>>) {
+            return MoveTemp(Value);
+        }
+        else if constexpr (std::is_same_v<U, TSharedPtr<FJsonObject>>) {
+            return MakeShared<FJsonValueObject>(MoveTemp(Value));
+        }
+        else if constexpr (std::is_same_v<U, TArray<TSharedPtr<FJsonValue>>>) {
+            return MakeShared<FJsonValueArray>(MoveTemp(Value));
+        }
+        else if constexpr (HasToJsonValue<U>::Value) {
+            return ToJsonValue<U>()(MoveTemp(Value));
+        }
+        else if constexpr (std::is_same_v<U, FString>) {
+            return MakeShared<FJsonValueString>(MoveTemp(Value));
+        }
+        else if constexpr (IsIteratable<U>::Value && !IsContainerCanToObject<U>::Value && !IsStruct<U>::Value && !CanConstructString<U>::Value) {
+            TArray<TSharedPtr<FJsonValue>> Data;
+            if constexpr (HasNum<U>::Value) {
+                Data.Reserve(Value.Num());
+            }
+            for (auto& E : Value) {
+                Data.Add(ToJValue(MoveTempIfPossible(E)));
+            }
+            return MakeShared<FJsonValueArray>(MoveTemp(Data));
+        }
+        else {
+            return ToJValue(static_cast<const U&>(Value));
+        }
+    }
+
     template<class V>
     static TSharedPtr<FJsonValue> ToJValue(std::initializer_list<V>&& Values)
     {
         TArray<TSharedPtr<FJsonValue>> Data;
+        Data.Reserve(Values.size());
         for (auto& E : Values) {
             Data.Add(ToJValue(E));
         }
-        return MakeShared<FJsonValueArray>(Data);
+        return MakeShared<FJsonValueArray>(MoveTemp(Data));
     }
     template<class... V>
     static TSharedPtr<FJsonValue> ToJValue(TTuple<V...>&& Values)
     {
         TArray<TSharedPtr<FJsonValue>> Data;
-        VisitTupleElements([&](auto& Value) { Data.Add(ToJValue(Value)); }, Values);
-        return MakeShared<FJsonValueArray>(Data);
+        Data.Reserve(sizeof...(V));
+        VisitTupleElements([&](auto& Value) { Data.Add(ToJValue(MoveTempIfPossible(Value))); }, Values);
+        return MakeShared<FJsonValueArray>(MoveTemp(Data));
     }
     template<class... V>
     static TSharedPtr<FJsonValue> ToJValue(TTuple<V&...>&& Values)
     {
         TArray<TSharedPtr<FJsonValue>> Data;
+        Data.Reserve(sizeof...(V));
         VisitTupleElements([&](auto& Value) { Data.Add(ToJValue(Value)); }, Values);
-        return MakeShared<FJsonValueArray>(Data);
+        return MakeShared<FJsonValueArray>(MoveTemp(Data));
     }
 #pragma endregion ToJson
 
@@ -493,6 +542,254 @@ public:
         return Ok;
     }
 #pragma endregion FromJson
+
+#pragma region Property
+    // conversion by runtime type information. follows the same rules as the compile-time versions above.
+    static bool IsNoExportScriptStruct(const UScriptStruct* Struct)
+    {
+        // structs declared in NoExportTypes.h (FVector, FGuid, etc.) belong to /Script/CoreUObject
+        return Struct->GetOutermost() == UObject::StaticClass()->GetOutermost();
+    }
+
+    static TSharedPtr<FJsonValue> ToJValue(const FProperty* Prop, const void* Value)
+    {
+        // static array
+        if (Prop->ArrayDim > 1) {
+            TArray<TSharedPtr<FJsonValue>> Data;
+            Data.Reserve(Prop->ArrayDim);
+            for (int32 I = 0; I < Prop->ArrayDim; ++I) {
+                Data.Add(ToJElement(Prop, (const uint8*)Value + Prop->ElementSize * I));
+            }
+            return MakeShared<FJsonValueArray>(MoveTemp(Data));
+        }
+        return ToJElement(Prop, Value);
+    }
+
+    static TSharedPtr<FJsonValue> ToJElement(const FProperty* Prop, const void* Value)
+    {
+        // bool
+        if (auto* BoolProp = CastField<FBoolProperty>(Prop)) {
+            return MakeShared<FJsonValueBoolean>(BoolProp->GetPropertyValue(Value));
+        }
+        // enum
+        else if (auto* EnumProp = CastField<FEnumProperty>(Prop)) {
+            return MakeShared<FJsonValueNumber>((double)EnumProp->GetUnderlyingProperty()->GetSignedIntPropertyValue(Value));
+        }
+        // number
+        else if (auto* NumProp = CastField<FNumericProperty>(Prop)) {
+            if (NumProp->IsFloatingPoint()) {
+                return MakeShared<FJsonValueNumber>(NumProp->GetFloatingPointPropertyValue(Value));
+            }
+            return MakeShared<FJsonValueNumber>((double)NumProp->GetSignedIntPropertyValue(Value));
+        }
+        // string
+        else if (auto* StrProp = CastField<FStrProperty>(Prop)) {
+            return MakeShared<FJsonValueString>(StrProp->GetPropertyValue(Value));
+        }
+        else if (auto* NameProp = CastField<FNameProperty>(Prop)) {
+            return MakeShared<FJsonValueString>(NameProp->GetPropertyValue(Value).ToString());
+        }
+        else if (auto* TextProp = CastField<FTextProperty>(Prop)) {
+            return MakeShared<FJsonValueString>(TextProp->GetPropertyValue(Value).ToString());
+        }
+        // struct
+        else if (auto* StructProp = CastField<FStructProperty>(Prop)) {
+            UScriptStruct* Struct = StructProp->Struct;
+            auto Ops = Struct->GetCppStructOps();
+            if (IsNoExportScriptStruct(Struct) && Ops && Ops->HasExportTextItem()) {
+                FString Ret;
+                Ops->ExportTextItem(Ret, Value, nullptr, nullptr, PPF_None, nullptr);
+                return MakeShared<FJsonValueString>(Ret);
+            }
+            auto Ret = MakeShared<FJsonObject>();
+            FJsonObjectConverter::UStructToJsonObject(Struct, Value, Ret);
+            return MakeShared<FJsonValueObject>(Ret);
+        }
+        // object reference
+        else if (auto* ObjProp = CastField<FObjectPropertyBase>(Prop)) {
+            if (UObject* Obj = ObjProp->GetObjectPropertyValue(Value)) {
+                return MakeShared<FJsonValueString>(Obj->GetPathName());
+            }
+            return MakeShared<FJsonValueNull>();
+        }
+        // array & set
+        else if (auto* ArrayProp = CastField<FArrayProperty>(Prop)) {
+            FScriptArrayHelper Helper(ArrayProp, Value);
+            TArray<TSharedPtr<FJsonValue>> Data;
+            Data.Reserve(Helper.Num());
+            for (int32 I = 0; I < Helper.Num(); ++I) {
+                Data.Add(ToJValue(ArrayProp->Inner, Helper.GetRawPtr(I)));
+            }
+            return MakeShared<FJsonValueArray>(MoveTemp(Data));
+        }
+        else if (auto* SetProp = CastField<FSetProperty>(Prop)) {
+            FScriptSetHelper Helper(SetProp, Value);
+            TArray<TSharedPtr<FJsonValue>> Data;
+            Data.Reserve(Helper.Num());
+            for (int32 I = 0; I < Helper.GetMaxIndex(); ++I) {
+                if (Helper.IsValidIndex(I)) {
+                    Data.Add(ToJValue(SetProp->ElementProp, Helper.GetElementPtr(I)));
+                }
+            }
+            return MakeShared<FJsonValueArray>(MoveTemp(Data));
+        }
+        // map
+        else if (auto* MapProp = CastField<FMapProperty>(Prop)) {
+            FScriptMapHelper Helper(MapProp, Value);
+            auto Ret = MakeShared<FJsonObject>();
+            for (int32 I = 0; I < Helper.GetMaxIndex(); ++I) {
+                if (Helper.IsValidIndex(I)) {
+                    FString Key;
+                    if (ToJValue(MapProp->KeyProp, Helper.GetKeyPtr(I))->TryGetString(Key)) {
+                        Ret->SetField(Key, ToJValue(MapProp->ValueProp, Helper.GetValuePtr(I)));
+                    }
+                }
+            }
+            return MakeShared<FJsonValueObject>(Ret);
+        }
+        // others
+        return FJsonObjectConverter::UPropertyToJsonValue(const_cast<FProperty*>(Prop), Value);
+    }
+
+    static bool FromJValue(const TSharedPtr<FJsonValue> Value, const FProperty* Prop, void* Dst)
+    {
+        if (!Value) {
+            return false;
+        }
+        // static array
+        if (Prop->ArrayDim > 1) {
+            const TArray<TSharedPtr<FJsonValue>>* Values;
+            if (!Value->TryGetArray(Values)) {
+                return false;
+            }
+            bool Ok = true;
+            for (int32 I = 0; I < Prop->ArrayDim && I < Values->Num(); ++I) {
+                if (!FromJElement((*Values)[I], Prop, (uint8*)Dst + Prop->ElementSize * I)) {
+                    Ok = false;
+                }
+            }
+            return Ok;
+        }
+        return FromJElement(Value, Prop, Dst);
+    }
+
+    static bool FromJElement(const TSharedPtr<FJsonValue> Value, const FProperty* Prop, void* Dst)
+    {
+        // bool
+        if (auto* BoolProp = CastField<FBoolProperty>(Prop)) {
+            bool Tmp;
+            if (Value->TryGetBool(Tmp)) {
+                BoolProp->SetPropertyValue(Dst, Tmp);
+                return true;
+            }
+            return false;
+        }
+        // enum. accepts both number and name
+        else if (auto* EnumProp = CastField<FEnumProperty>(Prop)) {
+            double Num;
+            FString Name;
+            if (Value->TryGetNumber(Num)) {
+                EnumProp->GetUnderlyingProperty()->SetIntPropertyValue(Dst, (int64)Num);
+                return true;
+            }
+            else if (Value->TryGetString(Name)) {
+                int64 Tmp = EnumProp->GetEnum()->GetValueByNameString(Name);
+                if (Tmp != INDEX_NONE) {
+                    EnumProp->GetUnderlyingProperty()->SetIntPropertyValue(Dst, Tmp);
+                    return true;
+                }
+            }
+            return false;
+        }
+        // number
+        else if (auto* NumProp = CastField<FNumericProperty>(Prop)) {
+            double Tmp;
+            if (Value->TryGetNumber(Tmp)) {
+                if (NumProp->IsFloatingPoint()) {
+                    NumProp->SetFloatingPointPropertyValue(Dst, Tmp);
+                }
+                else {
+                    NumProp->SetIntPropertyValue(Dst, (int64)Tmp);
+                }
+                return true;
+            }
+            return false;
+        }
+        // string
+        else if (auto* StrProp = CastField<FStrProperty>(Prop)) {
+            FString Tmp;
+            if (Value->TryGetString(Tmp)) {
+                StrProp->SetPropertyValue(Dst, MoveTemp(Tmp));
+                return true;
+            }
+            return false;
+        }
+        else if (auto* NameProp = CastField<FNameProperty>(Prop)) {
+            FString Tmp;
+            if (Value->TryGetString(Tmp)) {
+                NameProp->SetPropertyValue(Dst, FName(*Tmp));
+                return true;
+            }
+            return false;
+        }
+        else if (auto* TextProp = CastField<FTextProperty>(Prop)) {
+            FString Tmp;
+            if (Value->TryGetString(Tmp)) {
+                TextProp->SetPropertyValue(Dst, FText::FromString(MoveTemp(Tmp)));
+                return true;
+            }
+            return false;
+        }
+        // struct
+        else if (auto* StructProp = CastField<FStructProperty>(Prop)) {
+            UScriptStruct* Struct = StructProp->Struct;
+            auto Ops = Struct->GetCppStructOps();
+            FString StrValue;
+            TSharedPtr<FJsonObject>* Obj;
+            if (IsNoExportScriptStruct(Struct) && Ops && Ops->HasImportTextItem() && Value->TryGetString(StrValue)) {
+                const TCHAR* Buf = *StrValue;
+                return Ops->ImportTextItem(Buf, Dst, PPF_None, nullptr, nullptr);
+            }
+            else if (Value->TryGetObject(Obj)) {
+                return FJsonObjectConverter::JsonObjectToUStruct(Obj->ToSharedRef(), Struct, Dst);
+            }
+            return false;
+        }
+        // object reference. accepts path name or null
+        else if (auto* ObjProp = CastField<FObjectPropertyBase>(Prop)) {
+            FString Path;
+            if (Value->IsNull()) {
+                ObjProp->SetObjectPropertyValue(Dst, nullptr);
+                return true;
+            }
+            else if (Value->TryGetString(Path)) {
+                if (UObject* Obj = StaticLoadObject(ObjProp->PropertyClass, nullptr, *Path)) {
+                    ObjProp->SetObjectPropertyValue(Dst, Obj);
+                    return true;
+                }
+            }
+            return false;
+        }
+        // array
+        else if (auto* ArrayProp = CastField<FArrayProperty>(Prop)) {
+            const TArray<TSharedPtr<FJsonValue>>* Values;
+            if (!Value->TryGetArray(Values)) {
+                return false;
+            }
+            FScriptArrayHelper Helper(ArrayProp, Dst);
+            Helper.Resize(Values->Num());
+            bool Ok = true;
+            for (int32 I = 0; I < Values->Num(); ++I) {
+                if (!FromJValue((*Values)[I], ArrayProp->Inner, Helper.GetRawPtr(I))) {
+                    Ok = false;
+                }
+            }
+            return Ok;
+        }
+        // others
+        return FJsonObjectConverter::JsonValueToUProperty(Value, const_cast<FProperty*>(Prop), Dst);
+    }
+#pragma endregion Property
 };
 
 class JObject : public JObjectBase
@@ -590,10 +887,11 @@ public:
     {
         Set(MoveTemp(Fields));
     }
-    template<class... T>
-    JObject(T&&... Value)
+    // the single argument case must not hide the copy / move constructors
+    template<class T1, class... T, class = std::enable_if_t<(sizeof...(T) > 0) || !(std::is_same_v<std::decay_t<T1>, JObject> || std::is_same_v<std::decay_t<T1>, TSharedPtr<FJsonObject>>)>>
+    JObject(T1&& Value1, T&&... Value)
     {
-        Set(Forward<V>(Value)...);
+        Set(Forward<T1>(Value1), Forward<T>(Value)...);
     }
 
     // Set("field1", 1);
@@ -615,8 +913,10 @@ public:
     // Set({{"field1", 1}, {"field2", "abc"}});
     void Set(std::initializer_list<Field>&& Fields)
     {
-        for (auto& F : Fields) {
-            Data->SetField(F.Key, F.Value);
+        Data->Values.Reserve(Data->Values.Num() + (int32)Fields.size());
+        for (const Field& F : Fields) {
+            // initializer list elements are const and must not be moved from. copying Value only bumps the refcount
+            Data->Values.Add(F.Key, F.Value);
         }
     }
 
@@ -676,13 +976,17 @@ public:
     template<class K> auto operator[](const K& Key) { return Proxy<const K&>{ this, Key }; }
     template<class K> auto operator[](K&& Key) { return Proxy<FString>{ this, ToJKey(Key) }; }
 
-    TSharedPtr<FJsonObject> ToObject() const { return Data; }
-    TSharedPtr<FJsonValue> ToValue() const { return MakeShared<FJsonValueObject>(Data); }
+    TSharedPtr<FJsonObject> ToObject() const& { return Data; }
+    TSharedPtr<FJsonObject> ToObject() && { return MoveTemp(Data); }
+    TSharedPtr<FJsonValue> ToValue() const& { return MakeShared<FJsonValueObject>(Data); }
+    TSharedPtr<FJsonValue> ToValue() && { return MakeShared<FJsonValueObject>(MoveTemp(Data)); }
 
-    operator TSharedRef<FJsonObject>() { return ToObject().ToSharedRef(); }
-    operator TSharedPtr<FJsonObject>() { return ToObject(); }
-    operator TSharedRef<FJsonValue>() { return ToValue().ToSharedRef(); }
-    operator TSharedPtr<FJsonValue>() { return ToValue(); }
+    operator TSharedRef<FJsonObject>() const& { return ToObject().ToSharedRef(); }
+    operator TSharedPtr<FJsonObject>() const& { return ToObject(); }
+    operator TSharedPtr<FJsonObject>() && { return MoveTemp(*this).ToObject(); }
+    operator TSharedRef<FJsonValue>() const& { return ToValue().ToSharedRef(); }
+    operator TSharedPtr<FJsonValue>() const& { return ToValue(); }
+    operator TSharedPtr<FJsonValue>() && { return MoveTemp(*this).ToValue(); }
 
 public:
     using Container = TMap<FString, TSharedPtr<FJsonValue>>;
@@ -729,24 +1033,30 @@ public:
     {
         Add(MoveTemp(Values));
     }
-    template<class... V>
-    JArray(V&&... Value)
+    // the single argument case must not hide the copy / move constructors
+    template<class V1, class... V, class = std::enable_if_t<(sizeof...(V) > 0) || !(std::is_same_v<std::decay_t<V1>, JArray> || std::is_same_v<std::decay_t<V1>, TArray<TSharedPtr<FJsonValue>>>)>>
+    JArray(V1&& Value1, V&&... Value)
     {
-        Add(Forward<V>(Value)...);
+        Add(Forward<V1>(Value1), Forward<V>(Value)...);
     }
 
     template<class... V>
     void Add(V&&... Values)
     {
-        ([&] { Data.Add(ToJValue(Values)); } (), ...);
+        ([&] { Data.Add(ToJValue(Forward<V>(Values))); } (), ...);
     }
     template<class V>
     void Add(std::initializer_list<V>&& Values)
     {
+        Data.Reserve(Data.Num() + (int32)Values.size());
         for (auto& E : Values) {
             Data.Add(ToJValue(E));
         }
     }
+    void Reserve(int32 Num)
+    {
+        Data.Reserve(Num);
+    }
     template<class... V>
     void Add(TTuple<V...>&& Values)
     {
@@ -786,12 +1096,17 @@ public:
     }
 
 
-    TSharedPtr<FJsonValue> ToValue() const { return MakeShared<FJsonValueArray>(Data); }
-    TArray<TSharedPtr<FJsonValue>> ToArray() const { return Data; }
+    // the const& versions copy the whole array. use MoveTemp(Array).ToValue() etc. when the array is no longer needed
+    TSharedPtr<FJsonValue> ToValue() const& { return MakeShared<FJsonValueArray>(Data); }
+    TSharedPtr<FJsonValue> ToValue() && { return MakeShared<FJsonValueArray>(MoveTemp(Data)); }
+    TArray<TSharedPtr<FJsonValue>> ToArray() const& { return Data; }
+    TArray<TSharedPtr<FJsonValue>> ToArray() && { return MoveTemp(Data); }
 
-    operator TSharedRef<FJsonValue>() { return ToValue().ToSharedRef(); }
-    operator TSharedPtr<FJsonValue>() { return ToValue(); }
-    operator TArray<TSharedPtr<FJsonValue>>() { return Data; }
+    operator TSharedRef<FJsonValue>() const& { return ToValue().ToSharedRef(); }
+    operator TSharedPtr<FJsonValue>() const& { return ToValue(); }
+    operator TSharedPtr<FJsonValue>() && { return MoveTemp(*this).ToValue(); }
+    operator TArray<TSharedPtr<FJsonValue>>() const& { return Data; }
+    operator TArray<TSharedPtr<FJsonValue>>() && { return MoveTemp(Data); }
 
 public:
     using Container = TArray<TSharedPtr<FJsonValue>>;
@@ -847,6 +1162,10 @@ struct ToJsonValue<JObject>
     {
         return V.ToValue();
     }
+    TSharedPtr<FJsonValue> operator()(JObject&& V) const
+    {
+        return MoveTemp(V).ToValue();
+    }
 };
 template<>
 struct ToJsonValue<JArray>
@@ -855,6 +1174,10 @@ struct ToJsonValue<JArray>
     {
         return V.ToValue();
     }
+    TSharedPtr<FJsonValue> operator()(JArray&& V) const
+    {
+        return MoveTemp(V).ToValue();
+    }
 };
 template<class Char>
 struct ToJsonValue<std::basic_string<Char>>
@@ -0,0 +1,190 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/OutputDevice.h"
+#include <atomic>
+
+
+// Bounded multi-producer log buffer.
+// A message claims consecutive sequence numbers with a single fetch_add and is copied into fixed size slots, so logging
+// never allocates and never takes a lock. Each slot is guarded by its own stamp (a seqlock): a reader copies the slot and
+// then checks that the stamp did not move, which detects records overwritten while being read.
+// Sequence numbers double as cursors for incremental reads. Once writers are more than Capacity slots ahead of a cursor,
+// the records in between are gone and are reported as dropped.
+class FLogRing : public FOutputDevice
+{
+public:
+    // a message longer than this spans several consecutive slots
+    static constexpr int32 SlotChars = 240;
+
+    struct FRecord
+    {
+        uint64 Seq = 0;
+        double Time = 0.0;
+        ELogVerbosity::Type Verbosity = ELogVerbosity::Log;
+        FName Category;
+        FString Text;
+    };
+
+    explicit FLogRing(int32 InCapacity)
+    {
+        Capacity = FMath::RoundUpToPowerOfTwo((uint32)FMath::Max(InCapacity, 64));
+        Slots.Reset(new FSlot[Capacity]);
+    }
+
+    void Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const FName& Category) override
+    {
+        Write(V, Verbosity, Category);
+    }
+
+    bool CanBeUsedOnMultipleThreads() const override
+    {
+        return true;
+    }
+
+    // next sequence number to be written
+    uint64 GetHead() const
+    {
+        return Head.load(std::memory_order_acquire);
+    }
+
+    void Write(const TCHAR* Text, ELogVerbosity::Type Verbosity, const FName& Category)
+    {
+        int32 Len = FCString::Strlen(Text);
+        // a message larger than the whole ring keeps only its tail
+        const int32 MaxLen = (int32)Capacity * SlotChars;
+        if (Len > MaxLen) {
+            Text += Len - MaxLen;
+            Len = MaxLen;
+        }
+        const int32 NumSlots = FMath::Max(1, FMath::DivideAndRoundUp(Len, SlotChars));
+        const uint64 First = Head.fetch_add(NumSlots, std::memory_order_relaxed);
+        const double Time = FPlatformTime::Seconds() - GStartTime;
+
+        for (int32 Part = 0; Part < NumSlots; ++Part) {
+            const uint64 Seq = First + Part;
+            FSlot& Slot = Slots[Seq & (Capacity - 1)];
+            if (!AcquireSlot(Slot, Seq)) {
+                continue;
+            }
+            const int32 Offset = Part * SlotChars;
+            Slot.Time = Time;
+            Slot.Verbosity = (uint8)(Verbosity & ELogVerbosity::VerbosityMask);
+            Slot.Category = Category;
+            Slot.Part = (uint16)Part;
+            Slot.bLast = Part + 1 == NumSlots;
+            Slot.Len = (uint16)FMath::Min(SlotChars, Len - Offset);
+            FMemory::Memcpy(Slot.Text, Text + Offset, Slot.Len * sizeof(TCHAR));
+            Slot.Stamp.store(Committed(Seq), std::memory_order_release);
+        }
+    }
+
+    // Appends records starting at Cursor to Dst, up to MaxRecords, and returns the cursor to continue from.
+    // Reading stops at a slot that is still being written; a message split across slots is returned whole or not at all.
+    // OutDropped receives the number of slots that were overwritten before they could be read.
+    uint64 Read(uint64 Cursor, int32 MaxRecords, TArray<FRecord>& Dst, uint64& OutDropped) const
+    {
+        OutDropped = 0;
+        const uint64 End = GetHead();
+        if (Cursor > End) {
+            // a cursor from another session
+            Cursor = End;
+        }
+        if (End - Cursor > Capacity) {
+            OutDropped += End - Capacity - Cursor;
+            Cursor = End - Capacity;
+        }
+
+        TCHAR Buf[SlotChars];
+        FRecord Pending;
+        bool bPending = false;
+        uint64 Seq = Cursor;
+        for (; Seq < End && Dst.Num() < MaxRecords; ++Seq) {
+            const FSlot& Slot = Slots[Seq & (Capacity - 1)];
+            const uint64 Stamp = Slot.Stamp.load(std::memory_order_acquire);
+            if (Stamp < Committed(Seq)) {
+                // claimed but not written yet
+                break;
+            }
+
+            const double Time = Slot.Time;
+            const uint8 Verbosity = Slot.Verbosity;
+            const FName Category = Slot.Category;
+            const uint16 Part = Slot.Part;
+            const bool bLast = Slot.bLast;
+            const int32 Len = FMath::Min((int32)Slot.Len, SlotChars);
+            FMemory::Memcpy(Buf, Slot.Text, Len * sizeof(TCHAR));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (Stamp != Committed(Seq) || Slot.Stamp.load(std::memory_order_relaxed) != Stamp) {
+                // overwritten by a later message
+                ++OutDropped;
+                bPending = false;
+                continue;
+            }
+
+            if (Part == 0) {
+                Pending.Seq = Seq;
+                Pending.Time = Time;
+                Pending.Verbosity = (ELogVerbosity::Type)Verbosity;
+                Pending.Category = Category;
+                Pending.Text.Reset(Len);
+                bPending = true;
+            }
+            else if (!bPending) {
+                // the head of this message was lost
+                ++OutDropped;
+                continue;
+            }
+            Pending.Text.AppendChars(Buf, Len);
+            if (bLast) {
+                Dst.Add(MoveTemp(Pending));
+                Pending = {};
+                bPending = false;
+            }
+        }
+        // an unfinished message is read again from its first slot next time
+        return bPending ? Pending.Seq : Seq;
+    }
+
+private:
+    struct FSlot
+    {
+        // 0: never written, Seq * 2 + 1: being written, (Seq + 1) * 2: holds Seq
+        std::atomic<uint64> Stamp{ 0 };
+        double Time = 0.0;
+        FName Category;
+        uint16 Part = 0;
+        uint16 Len = 0;
+        uint8 Verbosity = 0;
+        bool bLast = true;
+        TCHAR Text[SlotChars];
+    };
+
+    static uint64 Writing(uint64 Seq) { return Seq * 2 + 1; }
+    static uint64 Committed(uint64 Seq) { return (Seq + 1) * 2; }
+
+    // Takes the slot over for Seq. Fails when a writer that is a whole lap ahead has already taken it.
+    // Waiting only happens when the previous owner of the slot, a full lap behind, is still copying.
+    static bool AcquireSlot(FSlot& Slot, uint64 Seq)
+    {
+        uint64 Cur = Slot.Stamp.load(std::memory_order_relaxed);
+        for (;;) {
+            if (Cur >= Writing(Seq)) {
+                return false;
+            }
+            if (Cur & 1) {
+                FPlatformProcess::YieldThread();
+                Cur = Slot.Stamp.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (Slot.Stamp.compare_exchange_weak(Cur, Writing(Seq), std::memory_order_acquire, std::memory_order_relaxed)) {
+                std::atomic_thread_fence(std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    uint64 Capacity = 0;
+    TUniquePtr<FSlot[]> Slots;
+    std::atomic<uint64> Head{ 0 };
+};
@@ -0,0 +1,405 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+
+// Dynamic AABB tree (a.k.a. dynamic BVH)
+// Leaves hold "fat" boxes expanded by Margin, so small moves don't need to touch the tree at all.
+// Insertion picks the sibling by surface area heuristic, and the tree is kept balanced by AVL-like rotations.
+// Query results are candidates by fat box; exact tests are up to the caller.
+template<class T>
+class TDynamicBVH
+{
+public:
+    static constexpr int32 Null = INDEX_NONE;
+
+    struct FNode
+    {
+        FBox Box;
+        T Data;
+        int32 Parent = Null;
+        int32 Child1 = Null;
+        int32 Child2 = Null;
+        int32 Height = 0; // leaf = 0, free node = -1
+
+        bool IsLeaf() const { return Child1 == Null; }
+    };
+
+    explicit TDynamicBVH(double InMargin = 0.0)
+        : Margin(InMargin)
+    {}
+
+    void Clear()
+    {
+        Nodes.Reset();
+        Root = Null;
+        FreeList = Null;
+        NumLeaves = 0;
+    }
+
+    int32 Num() const { return NumLeaves; }
+    bool IsEmpty() const { return NumLeaves == 0; }
+
+    const FBox& GetFatBox(int32 Id) const { return Nodes[Id].Box; }
+    const T& GetData(int32 Id) const { return Nodes[Id].Data; }
+    T& GetData(int32 Id) { return Nodes[Id].Data; }
+
+    // returns proxy id
+    int32 Insert(const FBox& Box, T Data)
+    {
+        int32 Id = AllocateNode();
+        Nodes[Id].Box = Box.ExpandBy(Margin);
+        Nodes[Id].Data = MoveTemp(Data);
+        Nodes[Id].Height = 0;
+        InsertLeaf(Id);
+        ++NumLeaves;
+        return Id;
+    }
+
+    void Remove(int32 Id)
+    {
+        RemoveLeaf(Id);
+        FreeNode(Id);
+        --NumLeaves;
+    }
+
+    // returns true if the tree structure was changed
+    bool Update(int32 Id, const FBox& Box)
+    {
+        if (Nodes[Id].Box.IsInside(Box)) {
+            return false;
+        }
+        RemoveLeaf(Id);
+        Nodes[Id].Box = Box.ExpandBy(Margin);
+        InsertLeaf(Id);
+        return true;
+    }
+
+    // Overlap: bool(const FBox& FatBox)
+    // Visit: bool(int32 LeafId) - return false to stop
+    template<class Overlap, class Visit>
+    void Query(Overlap&& Test, Visit&& F) const
+    {
+        if (Root == Null) {
+            return;
+        }
+        TArray<int32, TInlineAllocator<256>> Stack;
+        Stack.Push(Root);
+        while (!Stack.IsEmpty()) {
+            int32 Id = Stack.Pop(false);
+            const FNode& Node = Nodes[Id];
+            if (!Test(Node.Box)) {
+                continue;
+            }
+            if (Node.IsLeaf()) {
+                if (!F(Id)) {
+                    return;
+                }
+            }
+            else {
+                Stack.Push(Node.Child1);
+                Stack.Push(Node.Child2);
+            }
+        }
+    }
+
+    // best-first search for K nearest leaves
+    // LeafDistance: double(int32 LeafId) - exact squared distance. must be >= the squared distance to its fat box.
+    template<class LeafDistance>
+    void Nearest(const FVector& Point, int32 K, LeafDistance&& Dist, TArray<TPair<int32, double>>& Out) const
+    {
+        struct FItem
+        {
+            double Distance;
+            int32 Id;
+            bool Exact;
+        };
+        auto Pred = [](const FItem& A, const FItem& B) { return A.Distance < B.Distance; };
+
+        if (Root == Null || K <= 0) {
+            return;
+        }
+        TArray<FItem> Heap;
+        Heap.HeapPush(FItem{ Nodes[Root].Box.ComputeSquaredDistanceToPoint(Point), Root, false }, Pred);
+        while (!Heap.IsEmpty() && Out.Num() < K) {
+            FItem Item;
+            Heap.HeapPop(Item, Pred, false);
+            const FNode& Node = Nodes[Item.Id];
+            if (Item.Exact) {
+                Out.Emplace(Item.Id, Item.Distance);
+            }
+            else if (Node.IsLeaf()) {
+                Heap.HeapPush(FItem{ Dist(Item.Id), Item.Id, true }, Pred);
+            }
+            else {
+                Heap.HeapPush(FItem{ Nodes[Node.Child1].Box.ComputeSquaredDistanceToPoint(Point), Node.Child1, false }, Pred);
+                Heap.HeapPush(FItem{ Nodes[Node.Child2].Box.ComputeSquaredDistanceToPoint(Point), Node.Child2, false }, Pred);
+            }
+        }
+    }
+
+    // a direction component below this is treated as parallel to the slab
+    static constexpr double ParallelEpsilon = 1e-8;
+
+    // reciprocal of Dir for RayBox(). near-zero components map to a value RayBox() recognizes as parallel,
+    // instead of +-inf which turns into NaN when Origin lies exactly on a slab plane (0 * inf).
+    static FVector InverseDir(const FVector& Dir)
+    {
+        auto Inv = [](double V) { return FMath::Abs(V) < ParallelEpsilon ? TNumericLimits<double>::Max() : 1.0 / V; };
+        return FVector(Inv(Dir.X), Inv(Dir.Y), Inv(Dir.Z));
+    }
+
+    // slab test. returns entry distance along Dir (0 if Origin is inside), or a negative value if missed.
+    // InvDir is expected to come from InverseDir().
+    static double RayBox(const FVector& Origin, const FVector& InvDir, double MaxDistance, const FBox& Box)
+    {
+        double TMin = 0.0, TMax = MaxDistance;
+        for (int32 I = 0; I < 3; ++I) {
+            if (FMath::Abs(InvDir[I]) >= 1.0 / ParallelEpsilon) {
+                // the ray runs parallel to this slab: it is inside the slab for its whole length or never
+                if (Origin[I] < Box.Min[I] || Origin[I] > Box.Max[I]) {
+                    return -1.0;
+                }
+                continue;
+            }
+            double T1 = (Box.Min[I] - Origin[I]) * InvDir[I];
+            double T2 = (Box.Max[I] - Origin[I]) * InvDir[I];
+            TMin = FMath::Max(TMin, FMath::Min(T1, T2));
+            TMax = FMath::Min(TMax, FMath::Max(T1, T2));
+        }
+        return TMin <= TMax ? TMin : -1.0;
+    }
+
+    static double SurfaceArea(const FBox& Box)
+    {
+        FVector S = Box.GetSize();
+        return 2.0 * (S.X * S.Y + S.Y * S.Z + S.Z * S.X);
+    }
+
+private:
+    int32 AllocateNode()
+    {
+        if (FreeList != Null) {
+            int32 Id = FreeList;
+            FreeList = Nodes[Id].Parent;
+            Nodes[Id] = FNode();
+            return Id;
+        }
+        return Nodes.Emplace();
+    }
+
+    void FreeNode(int32 Id)
+    {
+        Nodes[Id] = FNode();
+        Nodes[Id].Parent = FreeList;
+        Nodes[Id].Height = -1;
+        FreeList = Id;
+    }
+
+    void InsertLeaf(int32 Leaf)
+    {
+        if (Root == Null) {
+            Root = Leaf;
+            Nodes[Root].Parent = Null;
+            return;
+        }
+
+        // find the best sibling
+        const FBox LeafBox = Nodes[Leaf].Box;
+        int32 Index = Root;
+        while (!Nodes[Index].IsLeaf()) {
+            const FNode& Node = Nodes[Index];
+            double Area = SurfaceArea(Node.Box);
+            double CombinedArea = SurfaceArea(Node.Box + LeafBox);
+
+            // cost of creating a new parent for this node and the new leaf
+            double Cost = 2.0 * CombinedArea;
+            // minimum cost of pushing the leaf further down the tree
+            double InheritanceCost = 2.0 * (CombinedArea - Area);
+
+            auto ChildCost = [&](int32 Child) {
+                const FNode& C = Nodes[Child];
+                double NewArea = SurfaceArea(C.Box + LeafBox);
+                return (C.IsLeaf() ? NewArea : NewArea - SurfaceArea(C.Box)) + InheritanceCost;
+            };
+            double Cost1 = ChildCost(Node.Child1);
+            double Cost2 = ChildCost(Node.Child2);
+
+            if (Cost < Cost1 && Cost < Cost2) {
+                break;
+            }
+            Index = Cost1 < Cost2 ? Node.Child1 : Node.Child2;
+        }
+        int32 Sibling = Index;
+
+        // create a new parent
+        int32 OldParent = Nodes[Sibling].Parent;
+        int32 NewParent = AllocateNode();
+        Nodes[NewParent].Parent = OldParent;
+        Nodes[NewParent].Box = LeafBox + Nodes[Sibling].Box;
+        Nodes[NewParent].Height = Nodes[Sibling].Height + 1;
+        Nodes[NewParent].Child1 = Sibling;
+        Nodes[NewParent].Child2 = Leaf;
+        Nodes[Sibling].Parent = NewParent;
+        Nodes[Leaf].Parent = NewParent;
+        if (OldParent != Null) {
+            if (Nodes[OldParent].Child1 == Sibling) {
+                Nodes[OldParent].Child1 = NewParent;
+            }
+            else {
+                Nodes[OldParent].Child2 = NewParent;
+            }
+        }
+        else {
+            Root = NewParent;
+        }
+
+        Refit(Nodes[Leaf].Parent);
+    }
+
+    void RemoveLeaf(int32 Leaf)
+    {
+        if (Leaf == Root) {
+            Root = Null;
+            return;
+        }
+
+        int32 Parent = Nodes[Leaf].Parent;
+        int32 GrandParent = Nodes[Parent].Parent;
+        int32 Sibling = Nodes[Parent].Child1 == Leaf ? Nodes[Parent].Child2 : Nodes[Parent].Child1;
+
+        if (GrandParent != Null) {
+            // destroy parent and connect sibling to grand parent
+            if (Nodes[GrandParent].Child1 == Parent) {
+                Nodes[GrandParent].Child1 = Sibling;
+            }
+            else {
+                Nodes[GrandParent].Child2 = Sibling;
+            }
+            Nodes[Sibling].Parent = GrandParent;
+            FreeNode(Parent);
+            Refit(GrandParent);
+        }
+        else {
+            Root = Sibling;
+            Nodes[Sibling].Parent = Null;
+            FreeNode(Parent);
+        }
+        Nodes[Leaf].Parent = Null;
+    }
+
+    // walk back up the tree fixing heights and boxes
+    void Refit(int32 Index)
+    {
+        while (Index != Null) {
+            Index = Balance(Index);
+            FNode& Node = Nodes[Index];
+            const FNode& C1 = Nodes[Node.Child1];
+            const FNode& C2 = Nodes[Node.Child2];
+            Node.Height = 1 + FMath::Max(C1.Height, C2.Height);
+            Node.Box = C1.Box + C2.Box;
+            Index = Node.Parent;
+        }
+    }
+
+    // perform a left or right rotation if node A is imbalanced. returns the new root index.
+    int32 Balance(int32 IA)
+    {
+        FNode& A = Nodes[IA];
+        if (A.IsLeaf() || A.Height < 2) {
+            return IA;
+        }
+
+        int32 IB = A.Child1;
+        int32 IC = A.Child2;
+        FNode& B = Nodes[IB];
+        FNode& C = Nodes[IC];
+        int32 Diff = C.Height - B.Height;
+
+        auto ReplaceChild = [&](int32 Parent, int32 Old, int32 New) {
+            if (Parent == Null) {
+                Root = New;
+            }
+            else if (Nodes[Parent].Child1 == Old) {
+                Nodes[Parent].Child1 = New;
+            }
+            else {
+                Nodes[Parent].Child2 = New;
+            }
+        };
+
+        // rotate C up
+        if (Diff > 1) {
+            int32 IF = C.Child1;
+            int32 IG = C.Child2;
+            FNode& F = Nodes[IF];
+            FNode& G = Nodes[IG];
+
+            C.Child1 = IA;
+            C.Parent = A.Parent;
+            A.Parent = IC;
+            ReplaceChild(C.Parent, IA, IC);
+
+            if (F.Height > G.Height) {
+                C.Child2 = IF;
+                A.Child2 = IG;
+                G.Parent = IA;
+                A.Box = B.Box + G.Box;
+                C.Box = A.Box + F.Box;
+                A.Height = 1 + FMath::Max(B.Height, G.Height);
+                C.Height = 1 + FMath::Max(A.Height, F.Height);
+            }
+            else {
+                C.Child2 = IG;
+                A.Child2 = IF;
+                F.Parent = IA;
+                A.Box = B.Box + F.Box;
+                C.Box = A.Box + G.Box;
+                A.Height = 1 + FMath::Max(B.Height, F.Height);
+                C.Height = 1 + FMath::Max(A.Height, G.Height);
+            }
+            return IC;
+        }
+
+        // rotate B up
+        if (Diff < -1) {
+            int32 ID = B.Child1;
+            int32 IE = B.Child2;
+            FNode& D = Nodes[ID];
+            FNode& E = Nodes[IE];
+
+            B.Child1 = IA;
+            B.Parent = A.Parent;
+            A.Parent = IB;
+            ReplaceChild(B.Parent, IA, IB);
+
+            if (D.Height > E.Height) {
+                B.Child2 = ID;
+                A.Child1 = IE;
+                E.Parent = IA;
+                A.Box = C.Box + E.Box;
+                B.Box = A.Box + D.Box;
+                A.Height = 1 + FMath::Max(C.Height, E.Height);
+                B.Height = 1 + FMath::Max(A.Height, D.Height);
+            }
+            else {
+                B.Child2 = IE;
+                A.Child1 = ID;
+                D.Parent = IA;
+                A.Box = C.Box + D.Box;
+                B.Box = A.Box + E.Box;
+                A.Height = 1 + FMath::Max(C.Height, D.Height);
+                B.Height = 1 + FMath::Max(A.Height, E.Height);
+            }
+            return IB;
+        }
+        return IA;
+    }
+
+private:
+    TArray<FNode> Nodes;
+    int32 Root = Null;
+    int32 FreeList = Null;
+    int32 NumLeaves = 0;
+    double Margin = 0.0;
+};
@@ -0,0 +1,155 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "JsonUtils.h"
+
+
+// TMap compares FString and FName keys case-insensitively by default, which would merge "Foo" and "foo" into one
+// entry and hand back whichever spelling came first. Names and paths must round-trip exactly, so match them by case.
+// The default hashes are case-insensitive, which stays consistent with a case-sensitive match.
+template<class ValueType>
+struct TCaseSensitiveStringKeyFuncs : TDefaultMapKeyFuncs<FString, ValueType, false>
+{
+    static bool Matches(const FString& A, const FString& B)
+    {
+        return A.Equals(B, ESearchCase::CaseSensitive);
+    }
+};
+
+template<class ValueType>
+struct TCaseSensitiveNameKeyFuncs : TDefaultMapKeyFuncs<FName, ValueType, false>
+{
+    static bool Matches(FName A, FName B)
+    {
+        return A.IsEqual(B, ENameCase::CaseSensitive);
+    }
+};
+
+
+// Deduplicated strings for the compact response format.
+// Listings repeat the same class names and package prefixes over and over, so a compact response carries each
+// distinct string once in a shared table and the objects refer to them by index.
+//   { "strings": ["StaticMeshActor", "StaticMeshComponent", ...], "items": [ { "typeName": 0, ... }, ... ] }
+class FStringTable
+{
+public:
+    int32 Add(const FString& Str)
+    {
+        if (const int32* Found = Indices.Find(Str)) {
+            return *Found;
+        }
+        int32 Index = Strings.Add(Str);
+        Indices.Add(Str, Index);
+        return Index;
+    }
+
+    int32 Add(FName Name)
+    {
+        // FName comparison is much cheaper than hashing the string, so keep a separate lookup for names
+        if (const int32* Found = NameIndices.Find(Name)) {
+            return *Found;
+        }
+        int32 Index = Add(Name.ToString());
+        NameIndices.Add(Name, Index);
+        return Index;
+    }
+
+    int32 Num() const { return Strings.Num(); }
+    const FString& operator[](int32 Index) const { return Strings[Index]; }
+
+    JArray ToJson() const
+    {
+        JArray Ret;
+        Ret.Data.Reserve(Strings.Num());
+        for (auto& S : Strings) {
+            Ret.Data.Add(MakeShared<FJsonValueString>(S));
+        }
+        return Ret;
+    }
+
+private:
+    TArray<FString> Strings;
+    TMap<FString, int32, FDefaultSetAllocator, TCaseSensitiveStringKeyFuncs<int32>> Indices;
+    TMap<FName, int32, FDefaultSetAllocator, TCaseSensitiveNameKeyFuncs<int32>> NameIndices;
+};
+
+
+// Prefix-compressed trie of '/' separated paths (package paths, folder paths).
+// Every node is one path segment; a path is referenced by the index of its last node, and the client rebuilds it
+// by walking up the parents. Segment names live in the shared FStringTable.
+//   { "parents": [-1, 0, 1, 1], "names": [3, 4, 5, 6] }
+//   node 2 -> "/" + strings[3] + "/" + strings[4] + "/" + strings[5]
+// A parent is always created before its children, so parents[i] < i holds for every node.
+class FPathTrie
+{
+public:
+    explicit FPathTrie(FStringTable& InStrings)
+        : Strings(InStrings)
+    {}
+
+    // returns the node of the path, or -1 for an empty path
+    int32 Add(const FString& Path)
+    {
+        if (const int32* Found = PathCache.Find(Path)) {
+            return *Found;
+        }
+
+        int32 Node = -1;
+        const TCHAR* Begin = *Path;
+        const TCHAR* End = Begin + Path.Len();
+        for (const TCHAR* P = Begin; P < End;) {
+            while (P < End && *P == '/') {
+                ++P;
+            }
+            const TCHAR* SegmentBegin = P;
+            while (P < End && *P != '/') {
+                ++P;
+            }
+            if (P > SegmentBegin) {
+                Node = AddChild(Node, Strings.Add(FString((int32)(P - SegmentBegin), SegmentBegin)));
+            }
+        }
+        PathCache.Add(Path, Node);
+        return Node;
+    }
+
+    int32 Add(FName Path)
+    {
+        if (const int32* Found = NameCache.Find(Path)) {
+            return *Found;
+        }
+        int32 Node = Add(Path.ToString());
+        NameCache.Add(Path, Node);
+        return Node;
+    }
+
+    int32 Num() const { return Parents.Num(); }
+
+    JObject ToJson() const
+    {
+        return JObject({
+            { "parents", Parents },
+            { "names", Names },
+            });
+    }
+
+private:
+    int32 AddChild(int32 Parent, int32 Name)
+    {
+        auto Key = TPair<int32, int32>(Parent, Name);
+        if (const int32* Found = Children.Find(Key)) {
+            return *Found;
+        }
+        int32 Node = Parents.Add(Parent);
+        Names.Add(Name);
+        Children.Add(Key, Node);
+        return Node;
+    }
+
+    FStringTable& Strings;
+    TArray<int32> Parents;
+    TArray<int32> Names;
+    TMap<TPair<int32, int32>, int32> Children;
+    TMap<FString, int32, FDefaultSetAllocator, TCaseSensitiveStringKeyFuncs<int32>> PathCache;
+    TMap<FName, int32, FDefaultSetAllocator, TCaseSensitiveNameKeyFuncs<int32>> NameCache;
+};
@@ -0,0 +1,405 @@
+﻿#include "HTTPLink.h"
+#include "../JsonUtils.h"
+#include "../JsonArena.h"
+
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryWriter.h"
+#include "Tests/AutomationEditorCommon.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// unity build で他のファイルの static 関数とぶつからないよう名前空間に入れる
+namespace HTTPLinkBenchmarkTests
+{
+#pragma region Utilities
+// "/path?key=value&..." を FHTTPLinkRequest に
+static FHTTPLinkRequest MakeLinkRequest(const FString& Route)
+{
+    FHTTPLinkRequest Ret;
+    FString Query;
+    if (!Route.Split(TEXT("?"), &Ret.Path, &Query)) {
+        Ret.Path = Route;
+    }
+    TArray<FString> Pairs;
+    Query.ParseIntoArray(Pairs, TEXT("&"));
+    for (auto& Pair : Pairs) {
+        FString Key, Value;
+        if (!Pair.Split(TEXT("="), &Key, &Value)) {
+            Key = Pair;
+        }
+        Ret.QueryParams.Add(FGenericPlatformHttp::UrlDecode(Key), FGenericPlatformHttp::UrlDecode(Value));
+    }
+    return Ret;
+}
+
+static JObject MakeLatencyStats(TArray<double>& Latencies)
+{
+    if (Latencies.IsEmpty()) {
+        return {};
+    }
+
+    Latencies.Sort();
+    double Total = 0.0;
+    for (double L : Latencies) {
+        Total += L;
+    }
+    auto Percentile = [&](double P) {
+        int32 I = FMath::Clamp(FMath::RoundToInt(P * (Latencies.Num() - 1)), 0, Latencies.Num() - 1);
+        return Latencies[I] * 1000.0;
+    };
+    // ms
+    return JObject({
+        { "min", Latencies[0] * 1000.0 },
+        { "mean", Total / Latencies.Num() * 1000.0 },
+        { "p50", Percentile(0.50) },
+        { "p90", Percentile(0.90) },
+        { "p99", Percentile(0.99) },
+        { "max", Latencies.Last() * 1000.0 },
+        });
+}
+
+template<class T>
+static TArray<uint8> SerializeJson(T&& Json)
+{
+    TArray<uint8> Data;
+    FMemoryWriter MemWriter(Data);
+    FJsonSerializer::Serialize(Json, TJsonWriterFactory<UTF8CHAR>::Create(&MemWriter));
+    return Data;
+}
+
+static int64 GetEncodedSize(const FHTTPLinkResponse& Response)
+{
+    if (Response.ArenaJson) {
+        return Response.ArenaJson->Write().Num();
+    }
+    if (!Response.Json) {
+        return Response.Body.Num();
+    }
+    TArray<uint8> Data;
+    FMemoryWriter MemWriter(Data);
+    FJsonSerializer::Serialize(Response.Json, FString(), TJsonWriterFactory<UTF8CHAR>::Create(&MemWriter));
+    return Data.Num();
+}
+#pragma endregion Utilities
+
+
+#pragma region Benchmark
+// 負荷テスト & ベンチマーク
+// 新しいマップに合成アクタを配置したうえで、ローカルの HTTP クライアントを N 本並列に走らせて各 route を叩き、
+// requests/sec, レイテンシのパーセンタイル, メモリの最高水位を JSON で返す。
+// HTTP のリクエストはエディタの tick で処理されるので、完了は latent command で待つ。
+// -nullrhi のエディタでも動くので、CI で結果を比較する想定:
+//   UnrealEditor-Cmd <project> -nullrhi -ExecCmds="Automation RunTests HTTPLink.Benchmark.10k; Quit"
+// 以下のオプションをコマンドラインで指定できる:
+//   -HTTPLinkBenchClients=8 -HTTPLinkBenchRequests=200 -HTTPLinkBenchRoutes="/actor/list;/asset/list" -HTTPLinkBenchInProc -HTTPLinkBenchCache
+// InProc の場合はソケットを介さず Call() で直接コマンドを呼ぶ (コマンド実行 + JSON エンコードのみの計測)
+// /actor/list などはレスポンスキャッシュの対象で、そのままでは 2 回目以降がすべてキャッシュのヒットになり
+// ハンドラやエンコードのコストを計れない。そのため既定では各 route に nocache=true を付ける。
+// Cache を指定した場合はキャッシュを有効にしたまま計測する。どちらの場合もヒット数を cacheHits に出す
+// 結果は Saved/HTTPLink/benchmark-<actors>.json にも書き出す。
+class FHTTPLinkBenchmark : public TSharedFromThis<FHTTPLinkBenchmark>
+{
+public:
+    struct FSample
+    {
+        int32 Route = 0;
+        double Latency = 0.0; // in seconds
+        int64 Bytes = 0;
+        bool Ok = false;
+        bool CacheHit = false;
+    };
+
+    TArray<FString> Routes;
+    TArray<TWeakObjectPtr<AActor>> Actors;
+    TArray<FSample> Samples;
+    int32 NumClients = 8;
+    int32 NumRequests = 200;
+    int32 NumIssued = 0;
+    bool InProcess = false;
+    bool UseCache = false;
+    double SpawnTime = 0.0;
+    double BeginTime = 0.0;
+    uint64 HighWaterPhysical = 0;
+    uint64 HighWaterVirtual = 0;
+
+    FHTTPLinkBenchmark()
+    {
+        FString RoutesStr = TEXT("/actor/list;/asset/list");
+        FParse::Value(FCommandLine::Get(), TEXT("HTTPLinkBenchClients="), NumClients);
+        FParse::Value(FCommandLine::Get(), TEXT("HTTPLinkBenchRequests="), NumRequests);
+        FParse::Value(FCommandLine::Get(), TEXT("HTTPLinkBenchRoutes="), RoutesStr, false);
+        InProcess = FParse::Param(FCommandLine::Get(), TEXT("HTTPLinkBenchInProc"));
+        UseCache = FParse::Param(FCommandLine::Get(), TEXT("HTTPLinkBenchCache"));
+
+        RoutesStr.ParseIntoArray(Routes, TEXT(";"));
+        if (!UseCache) {
+            for (auto& Route : Routes) {
+                Route += Route.Contains(TEXT("?")) ? TEXT("&nocache=true") : TEXT("?nocache=true");
+            }
+        }
+        NumClients = FMath::Max(NumClients, 1);
+        NumRequests = FMath::Max(NumRequests, 1);
+    }
+
+    // 合成レベル: Cube の StaticMeshActor をグリッド状に並べる
+    // transient なので保存はされないし、Undo 履歴にも積まない
+    void Spawn(UWorld* World, int32 NumActors)
+    {
+        const double SpawnBegin = FPlatformTime::Seconds();
+        UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+        const int32 Side = FMath::Max(FMath::CeilToInt(FMath::Sqrt((double)NumActors)), 1);
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.ObjectFlags = RF_Transient;
+        SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+        Actors.Reserve(NumActors);
+        for (int32 I = 0; I < NumActors; ++I) {
+            FVector Location((I % Side) * 200.0, (I / Side) * 200.0, 0.0);
+            if (auto* Actor = World->SpawnActor<AStaticMeshActor>(Location, FRotator::ZeroRotator, SpawnParams)) {
+                Actor->GetStaticMeshComponent()->SetStaticMesh(Mesh);
+                Actor->SetActorLabel(FString::Printf(TEXT("HTTPLinkBench%d"), I));
+                Actors.Add(Actor);
+            }
+        }
+        SpawnTime = FPlatformTime::Seconds() - SpawnBegin;
+    }
+
+    void Start(FHTTPLinkModule& Module)
+    {
+        SampleMemory();
+        BeginTime = FPlatformTime::Seconds();
+        Samples.Reserve(NumRequests);
+        if (InProcess) {
+            TArray<FHTTPLinkRequest> Requests;
+            for (auto& Route : Routes) {
+                Requests.Add(MakeLinkRequest(Route));
+            }
+            while (NumIssued < NumRequests) {
+                const int32 RouteIndex = NumIssued++ % Routes.Num();
+                const double Begin = FPlatformTime::Seconds();
+                // HTTP と同じく arena 上の結果はそのままエンコードさせたいので、Call(Request, Response) (Json に変換する) は使わない
+                TOptional<FHTTPLinkResponse> Response;
+                Module.Call(Requests[RouteIndex], [&](FHTTPLinkResponse&& R) { Response.Emplace(MoveTemp(R)); });
+
+                FSample Sample;
+                Sample.Route = RouteIndex;
+                Sample.Bytes = Response ? GetEncodedSize(*Response) : 0;
+                Sample.Latency = FPlatformTime::Seconds() - Begin;
+                Sample.Ok = Response && Response->Code == EHttpServerResponseCodes::Ok;
+                Samples.Add(Sample);
+            }
+        }
+        else {
+            for (int32 I = 0; I < NumClients; ++I) {
+                Issue(Module.Port);
+            }
+        }
+    }
+
+    bool IsDone() const
+    {
+        return Samples.Num() >= NumRequests;
+    }
+
+    void SampleMemory()
+    {
+        auto Stats = FPlatformMemory::GetStats();
+        HighWaterPhysical = FMath::Max<uint64>(HighWaterPhysical, Stats.UsedPhysical);
+        HighWaterVirtual = FMath::Max<uint64>(HighWaterVirtual, Stats.UsedVirtual);
+    }
+
+    JObject Finish()
+    {
+        SampleMemory();
+        const double Elapsed = FPlatformTime::Seconds() - BeginTime;
+
+        int32 NumFailed = 0;
+        int32 NumCacheHits = 0;
+        TArray<double> Latencies;
+        TArray<TArray<double>> RouteLatencies;
+        TArray<int64> RouteBytes;
+        TArray<int32> RouteCacheHits;
+        RouteLatencies.SetNum(Routes.Num());
+        RouteBytes.SetNumZeroed(Routes.Num());
+        RouteCacheHits.SetNumZeroed(Routes.Num());
+        for (auto& S : Samples) {
+            if (!S.Ok) {
+                ++NumFailed;
+            }
+            if (S.CacheHit) {
+                ++NumCacheHits;
+                ++RouteCacheHits[S.Route];
+            }
+            Latencies.Add(S.Latency);
+            RouteLatencies[S.Route].Add(S.Latency);
+            RouteBytes[S.Route] += S.Bytes;
+        }
+
+        JObject RouteStats;
+        for (int32 I = 0; I < Routes.Num(); ++I) {
+            int32 Num = RouteLatencies[I].Num();
+            JObject Stats;
+            Stats["requests"] = Num;
+            Stats["bytesPerResponse"] = Num ? RouteBytes[I] / Num : 0;
+            Stats["cacheHits"] = RouteCacheHits[I];
+            Stats["latency"] = MakeLatencyStats(RouteLatencies[I]);
+            RouteStats[Routes[I]] = Stats;
+        }
+
+        auto MemStats = FPlatformMemory::GetStats();
+        JObject Json({
+            { "actors", Actors.Num() },
+            { "mode", InProcess ? TEXT("inproc") : TEXT("http") },
+            { "clients", NumClients },
+            { "requests", Samples.Num() },
+            { "failed", NumFailed },
+            { "cache", UseCache },
+            { "cacheHits", NumCacheHits },
+            { "spawnTime", SpawnTime },
+            { "elapsed", Elapsed },
+            { "requestsPerSec", Elapsed > 0.0 ? Samples.Num() / Elapsed : 0.0 },
+            { "latency", MakeLatencyStats(Latencies) },
+            { "routes", RouteStats },
+            { "memory", JObject({
+                { "highWaterUsedPhysical", HighWaterPhysical },
+                { "highWaterUsedVirtual", HighWaterVirtual },
+                { "peakUsedPhysical", MemStats.PeakUsedPhysical },
+                { "peakUsedVirtual", MemStats.PeakUsedVirtual },
+                }) },
+            });
+
+        // 一時マップなので保存はされないが、次のテストに持ち越さないよう片付けておく
+        for (auto& Actor : Actors) {
+            if (Actor.IsValid()) {
+                Actor->GetWorld()->DestroyActor(Actor.Get());
+            }
+        }
+        Actors.Empty();
+        return Json;
+    }
+
+private:
+    void Issue(int32 Port)
+    {
+        if (NumIssued >= NumRequests) {
+            return;
+        }
+
+        const int32 RouteIndex = NumIssued++ % Routes.Num();
+        const double Begin = FPlatformTime::Seconds();
+
+        auto HttpRequest = FHttpModule::Get().CreateRequest();
+        HttpRequest->SetURL(FString::Printf(TEXT("http://127.0.0.1:%d%s"), Port, *Routes[RouteIndex]));
+        HttpRequest->SetVerb(TEXT("GET"));
+        HttpRequest->OnProcessRequestComplete().BindLambda([Self = AsShared(), Port, RouteIndex, Begin](FHttpRequestPtr, FHttpResponsePtr Response, bool Succeeded) {
+            FSample Sample;
+            Sample.Route = RouteIndex;
+            Sample.Latency = FPlatformTime::Seconds() - Begin;
+            Sample.Bytes = Response ? (int64)Response->GetContentLength() : 0;
+            Sample.Ok = Succeeded && Response && Response->GetResponseCode() == EHttpResponseCodes::Ok;
+            Sample.CacheHit = Response && Response->GetHeader(TEXT("X-HTTPLink-Cache")) == TEXT("hit");
+            Self->Samples.Add(Sample);
+            Self->Issue(Port);
+            });
+        HttpRequest->ProcessRequest();
+    }
+};
+
+// 全リクエストの完了を待って結果をまとめる
+class FHTTPLinkBenchmarkCommand : public IAutomationLatentCommand
+{
+public:
+    FHTTPLinkBenchmarkCommand(FAutomationTestBase* InTest, const TSharedRef<FHTTPLinkBenchmark>& InBenchmark)
+        : Test(InTest)
+        , Benchmark(InBenchmark)
+    {}
+
+    bool Update() override
+    {
+        // 応答が返ってこないまま止まるのを防ぐ
+        const double Timeout = 600.0;
+
+        auto& B = *Benchmark;
+        B.SampleMemory();
+        if (!B.IsDone()) {
+            if (FPlatformTime::Seconds() - B.BeginTime < Timeout) {
+                return false;
+            }
+            Test->AddError(FString::Printf(TEXT("timed out after %d of %d requests"), B.Samples.Num(), B.NumRequests));
+        }
+
+        const int32 NumActors = B.Actors.Num();
+        JObject Json = B.Finish();
+        int32 NumFailed = 0;
+        double RequestsPerSec = 0.0;
+        Json["failed"] >> NumFailed;
+        Json["requestsPerSec"] >> RequestsPerSec;
+        int32 NumCacheHits = 0;
+        Json["cacheHits"] >> NumCacheHits;
+        Test->AddInfo(FString::Printf(TEXT("%d actors: %.1f requests/sec (%d cache hits)"), NumActors, RequestsPerSec, NumCacheHits));
+        if (NumFailed > 0) {
+            Test->AddError(FString::Printf(TEXT("%d requests failed"), NumFailed));
+        }
+        FFileHelper::SaveArrayToFile(SerializeJson(Json.Data.ToSharedRef()),
+            *(FPaths::ProjectSavedDir() / FString::Printf(TEXT("HTTPLink/benchmark-%d.json"), NumActors)));
+        return true;
+    }
+
+private:
+    FAutomationTestBase* Test;
+    TSharedRef<FHTTPLinkBenchmark> Benchmark;
+};
+} // namespace HTTPLinkBenchmarkTests
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FHTTPLinkBenchmarkTest, "HTTPLink.Benchmark",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+void FHTTPLinkBenchmarkTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+    const TPair<const TCHAR*, int32> Levels[] = {
+        { TEXT("1k"), 1000 },
+        { TEXT("10k"), 10000 },
+        { TEXT("100k"), 100000 },
+        { TEXT("500k"), 500000 },
+    };
+    for (auto& Level : Levels) {
+        OutBeautifiedNames.Add(Level.Key);
+        OutTestCommands.Add(FString::FromInt(Level.Value));
+    }
+}
+
+bool FHTTPLinkBenchmarkTest::RunTest(const FString& Parameters)
+{
+    using namespace HTTPLinkBenchmarkTests;
+
+    auto& Module = FModuleManager::GetModuleChecked<FHTTPLinkModule>("HTTPLink");
+    auto Benchmark = MakeShared<FHTTPLinkBenchmark>();
+    if (Benchmark->Routes.IsEmpty()) {
+        AddError(TEXT("no routes"));
+        return false;
+    }
+    if (!Benchmark->InProcess && !Module.Port) {
+        AddError(TEXT("HTTPLink is not listening"));
+        return false;
+    }
+
+    // 開いているレベルを汚さないよう、新しいマップの上で計測する
+    UWorld* World = FAutomationEditorCommonUtils::CreateNewMap();
+    if (!TestNotNull(TEXT("new map"), World)) {
+        return false;
+    }
+    Benchmark->Spawn(World, FMath::Max(FCString::Atoi(*Parameters), 1));
+    Benchmark->Start(Module);
+    ADD_LATENT_AUTOMATION_COMMAND(FHTTPLinkBenchmarkCommand(this, Benchmark));
+    return true;
+}
+#pragma endregion Benchmark
+
+#endif
@@ -0,0 +1,439 @@
+﻿#include "HTTPLink.h"
+#include "../JsonUtils.h"
+#include "../JsonArena.h"
+
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryWriter.h"
+#include "Tests/AutomationEditorCommon.h"
+#include "Engine/StaticMeshActor.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// unity build で他のファイルの static 関数とぶつからないよう名前空間に入れる
+namespace HTTPLinkJsonTests
+{
+#pragma region Utilities
+// メモリ確保回数の計測
+// GMalloc は差し替えず、stats が有効なビルドでアロケータ自身が数えている FMalloc の呼び出し回数を読む。
+// プロセス全体のカウンタなので他スレッドの確保も混ざる。計測は何度か繰り返して最小値をとる
+struct FAllocationCounter
+{
+    static uint64 Now()
+    {
+#if STATS
+        return (uint64)FMalloc::TotalMallocCalls + (uint64)FMalloc::TotalReallocCalls;
+#else
+        return 0;
+#endif
+    }
+
+    // アロケータがカウンタを更新しない (stats 無効や数えない FMalloc の) 場合は false
+    static bool IsAvailable()
+    {
+        const uint64 Begin = Now();
+        void* P = FMemory::Malloc(16);
+        const uint64 End = Now();
+        FMemory::Free(P);
+        return End != Begin;
+    }
+};
+
+template<class T>
+static TArray<uint8> SerializeJson(T&& Json)
+{
+    TArray<uint8> Data;
+    FMemoryWriter MemWriter(Data);
+    FJsonSerializer::Serialize(Json, TJsonWriterFactory<UTF8CHAR>::Create(&MemWriter));
+    return Data;
+}
+
+// 比較用の 1 行の JSON 文字列
+static FString ToJsonText(const TSharedPtr<FJsonValue>& Value)
+{
+    FString Ret;
+    FJsonSerializer::Serialize(Value, FString(), TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Ret));
+    return Ret;
+}
+
+// Value 以下の JSON の値の数 (Value 自身を含む)
+static int32 CountJsonValues(const TSharedPtr<FJsonValue>& Value)
+{
+    int32 Ret = 1;
+    const TArray<TSharedPtr<FJsonValue>>* Array;
+    const TSharedPtr<FJsonObject>* Object;
+    if (Value->TryGetArray(Array)) {
+        for (auto& E : *Array) {
+            Ret += CountJsonValues(E);
+        }
+    }
+    else if (Value->TryGetObject(Object)) {
+        for (auto& KVP : (*Object)->Values) {
+            Ret += CountJsonValues(KVP.Value);
+        }
+    }
+    return Ret;
+}
+
+template<class Body>
+static JObject MeasureJsonOp(int32 Iterations, Body&& F)
+{
+    const int32 Repeat = 3;
+    F(); // warm up
+
+    double Elapsed = TNumericLimits<double>::Max();
+    uint64 NumAllocs = TNumericLimits<uint64>::Max();
+    for (int32 R = 0; R < Repeat; ++R) {
+        const uint64 AllocBegin = FAllocationCounter::Now();
+        const double Begin = FPlatformTime::Seconds();
+        for (int32 I = 0; I < Iterations; ++I) {
+            F();
+        }
+        Elapsed = FMath::Min(Elapsed, FPlatformTime::Seconds() - Begin);
+        NumAllocs = FMath::Min(NumAllocs, FAllocationCounter::Now() - AllocBegin);
+    }
+    return JObject({
+        { "iterations", Iterations },
+        { "nsPerOp", Elapsed * 1000000000.0 / Iterations },
+        { "allocsPerOp", (double)NumAllocs / Iterations },
+        });
+}
+#pragma endregion Utilities
+} // namespace HTTPLinkJsonTests
+
+
+#pragma region Benchmark
+// JsonUtils.h のマイクロベンチマーク
+// 各操作の ns/op と allocs/op をログに出し、Saved/HTTPLink/jsonbench.json にも書き出す。
+// -nullrhi のエディタでも動く:
+//   UnrealEditor-Cmd <project> -nullrhi -ExecCmds="Automation RunTests HTTPLink.Json.Benchmark; Quit"
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHTTPLinkJsonBenchmarkTest, "HTTPLink.Json.Benchmark",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FHTTPLinkJsonBenchmarkTest::RunTest(const FString& Parameters)
+{
+    using namespace HTTPLinkJsonTests;
+
+    const int32 Iterations = 10000;
+    if (!FAllocationCounter::IsAvailable()) {
+        AddWarning(TEXT("allocation counters are not available in this build. allocsPerOp will be 0."));
+    }
+
+    // 実際のレスポンスに近い形のデータ
+    const FString Label = TEXT("StaticMeshActor_0");
+    const FGuid Guid = FGuid::NewGuid();
+    const FVector Vector(100, 200, 300);
+    const FTransform Transform(FQuat::Identity, Vector, FVector::OneVector);
+    TArray<int> IntArray;
+    for (int I = 0; I < 64; ++I) {
+        IntArray.Add(I);
+    }
+    TMap<FString, int> StringIntMap;
+    for (int I = 0; I < 16; ++I) {
+        StringIntMap.Add(FString::Printf(TEXT("field%d"), I), I);
+    }
+    auto MakeSummary = [&]() {
+        JObject Ret({
+            { "typeName", TEXT("StaticMeshActor") },
+            { "label", Label },
+            { "name", FName("StaticMeshActor_0") },
+            { "guid", Guid },
+            { "transform", Transform },
+            });
+        JArray Components;
+        Components.Add(JObject({ { "typeName", TEXT("StaticMeshComponent") }, { "name", TEXT("StaticMeshComponent0") } }));
+        Ret["components"] = MoveTemp(Components);
+        return Ret;
+    };
+
+    FString ListString;
+    {
+        JArray List;
+        for (int I = 0; I < 100; ++I) {
+            List.Add(MakeSummary());
+        }
+        FJsonSerializer::Serialize(List.Data, TJsonWriterFactory<>::Create(&ListString));
+    }
+    const FString ParamString = TEXT(R"({"guid":"0123456789ABCDEF0123456789ABCDEF","t":{"x":1,"y":2,"z":3},"r":{"x":0,"y":0,"z":0,"w":1},"abs":false})");
+    JObject Params = JObject::Parse(ParamString);
+    JObject Summary = MakeSummary();
+
+    // 計測対象が正しく動いていることを先に確かめておく
+    {
+        FVector T; FQuat R; bool Abs = true;
+        Params["t"] >> T;
+        Params["r"] >> R;
+        Params["abs"] >> Abs;
+        TestEqual(TEXT("extract vector"), T, FVector(1, 2, 3));
+        TestTrue(TEXT("extract quat"), R.Equals(FQuat::Identity));
+        TestFalse(TEXT("extract bool"), Abs);
+
+        FTransform Tmp;
+        Summary["transform"] >> Tmp;
+        TestTrue(TEXT("extract transform"), Tmp.Equals(Transform));
+        TestEqual(TEXT("parse list"), JArray::Parse(ListString).Data.Num(), 100);
+    }
+
+    JObject Json;
+    // construction
+    Json["jobjectConstruct"] = MeasureJsonOp(Iterations, [&]() {
+        JObject Tmp({ { "int", 1 }, { "string", TEXT("str") }, { "bool", true } });
+        });
+    Json["jarrayConstruct"] = MeasureJsonOp(Iterations, [&]() {
+        JArray Tmp;
+        Tmp.Add(0, 1, 2, 3, 4, 5, 6, 7);
+        });
+    Json["actorSummary"] = MeasureJsonOp(Iterations, [&]() {
+        MakeSummary();
+        });
+    // 同じ内容を JsonArena.h で構築 + エンコード
+    auto MakeArenaSummary = [&](FJsonArenaDocument& Doc) {
+        const FVector T = Transform.GetTranslation();
+        FJsonArenaValue* Translation = Doc.MakeObject(3);
+        Doc.Set(Translation, "x", Doc.MakeNumber(T.X));
+        Doc.Set(Translation, "y", Doc.MakeNumber(T.Y));
+        Doc.Set(Translation, "z", Doc.MakeNumber(T.Z));
+        FJsonArenaValue* Component = Doc.MakeObject(2);
+        Doc.Set(Component, "typeName", Doc.MakeString(TEXT("StaticMeshComponent")));
+        Doc.Set(Component, "name", Doc.MakeString(TEXT("StaticMeshComponent0")));
+        FJsonArenaValue* Components = Doc.MakeArray(1);
+        Doc.Add(Components, Component);
+
+        FJsonArenaValue* Ret = Doc.MakeObject(6);
+        Doc.Set(Ret, "typeName", Doc.MakeString(TEXT("StaticMeshActor")));
+        Doc.Set(Ret, "label", Doc.MakeString(Label));
+        Doc.Set(Ret, "name", Doc.MakeString(FName("StaticMeshActor_0")));
+        Doc.Set(Ret, "guid", Doc.MakeString(Guid.ToString()));
+        Doc.Set(Ret, "translation", Translation);
+        Doc.Set(Ret, "components", Components);
+        return Ret;
+    };
+    Json["arenaActorSummary"] = MeasureJsonOp(Iterations, [&]() {
+        FJsonArenaDocument Doc;
+        MakeArenaSummary(Doc);
+        });
+    Json["arenaActorList100Write"] = MeasureJsonOp(FMath::Max(Iterations / 100, 1), [&]() {
+        FJsonArenaDocument Doc;
+        FJsonArenaValue* List = Doc.MakeArray(100);
+        for (int I = 0; I < 100; ++I) {
+            Doc.Add(List, MakeArenaSummary(Doc));
+        }
+        Doc.SetRoot(List);
+        Doc.Write();
+        });
+    Json["jobjectActorList100Write"] = MeasureJsonOp(FMath::Max(Iterations / 100, 1), [&]() {
+        JArray List;
+        for (int I = 0; I < 100; ++I) {
+            List.Add(MakeSummary());
+        }
+        HTTPLinkJsonTests::SerializeJson(List.Data);
+        });
+
+    // ToJValue
+    Json["toJValueNumber"] = MeasureJsonOp(Iterations, [&]() {
+        JObject::ToJValue(Iterations);
+        });
+    Json["toJValueString"] = MeasureJsonOp(Iterations, [&]() {
+        JObject::ToJValue(Label);
+        });
+    Json["toJValueNoExportStruct"] = MeasureJsonOp(Iterations, [&]() {
+        JObject::ToJValue(Vector);
+        });
+    Json["toJValueTransform"] = MeasureJsonOp(Iterations, [&]() {
+        JObject::ToJValue(Transform);
+        });
+    Json["toJValueArray"] = MeasureJsonOp(Iterations, [&]() {
+        JObject::ToJValue(IntArray);
+        });
+    Json["toJValueMap"] = MeasureJsonOp(Iterations, [&]() {
+        JObject::ToJValue(StringIntMap);
+        });
+    Json["toJValueTuple"] = MeasureJsonOp(Iterations, [&]() {
+        JObject::ToJValue(MakeTuple(true, 100, TEXT("str"), Vector));
+        });
+
+    // Parse
+    Json["parseParams"] = MeasureJsonOp(Iterations, [&]() {
+        JObject::Parse(ParamString);
+        });
+    Json["parseActorList100"] = MeasureJsonOp(FMath::Max(Iterations / 100, 1), [&]() {
+        JArray::Parse(ListString);
+        });
+
+    // >> extraction
+    Json["extractVector"] = MeasureJsonOp(Iterations, [&]() {
+        FVector Tmp;
+        Params["t"] >> Tmp;
+        });
+    Json["extractGuid"] = MeasureJsonOp(Iterations, [&]() {
+        FGuid Tmp;
+        Params["guid"] >> Tmp;
+        });
+    Json["extractTransform"] = MeasureJsonOp(Iterations, [&]() {
+        FTransform Tmp;
+        Summary["transform"] >> Tmp;
+        });
+    Json["extractTransformParams"] = MeasureJsonOp(Iterations, [&]() {
+        FVector T; FQuat R; bool Abs;
+        Params["t"] >> T;
+        Params["r"] >> R;
+        Params["abs"] >> Abs;
+        });
+
+    for (auto& KVP : Json.Data->Values) {
+        const TSharedPtr<FJsonObject>& Op = KVP.Value->AsObject();
+        AddInfo(FString::Printf(TEXT("%s: %.1f ns/op, %.2f allocs/op"), *KVP.Key,
+            Op->GetNumberField(TEXT("nsPerOp")), Op->GetNumberField(TEXT("allocsPerOp"))));
+    }
+    FFileHelper::SaveArrayToFile(HTTPLinkJsonTests::SerializeJson(Json.Data.ToSharedRef()), *(FPaths::ProjectSavedDir() / TEXT("HTTPLink/jsonbench.json")));
+    return true;
+}
+#pragma endregion Benchmark
+
+
+#pragma region Arena
+// FJsonArenaDocument::Make() が JObject::ToJValue() と同じ JSON を作ることを確認する
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHTTPLinkJsonArenaMakeTest, "HTTPLink.Json.ArenaMake",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHTTPLinkJsonArenaMakeTest::RunTest(const FString& Parameters)
+{
+    using namespace HTTPLinkJsonTests;
+
+    FJsonArenaDocument Doc;
+    auto Check = [&](const TCHAR* What, const auto& Value) {
+        TestEqual(What, ToJsonText(FJsonArenaDocument::ToJsonValue(*Doc.Make(Value))), ToJsonText(JObject::ToJValue(Value)));
+    };
+    Check(TEXT("bool"), true);
+    Check(TEXT("int"), 42);
+    Check(TEXT("double"), 0.25);
+    Check(TEXT("string"), FString(TEXT("a\"b\\c")));
+    Check(TEXT("literal"), TEXT("StaticMeshComponent"));
+    Check(TEXT("name"), FName("StaticMeshActor_0"));
+    Check(TEXT("guid"), FGuid::NewGuid());
+    Check(TEXT("vector"), FVector(1, 2.5, -3));
+    Check(TEXT("quat"), FQuat(FRotator(10, 20, 30)));
+    Check(TEXT("rotator"), FRotator(10, 20, 30));
+    Check(TEXT("transform"), FTransform(FRotator(10, 20, 30), FVector(1, 2, 3), FVector(1, 1, 2)));
+    Check(TEXT("array"), TArray<int32>{ 1, 2, 3 });
+    Check(TEXT("string array"), TArray<FString>{ TEXT("a"), TEXT("b") });
+    return true;
+}
+#pragma endregion Arena
+
+
+#pragma region Allocation
+// アクタの一覧を作る際のアロケーション回数が件数に比例する (1 件あたりのコストが一定) ことを確認する
+// 新しいマップに StaticMeshActor を N 件まで増やしながら /actor/list を in-process で呼んでエンコードし、件数ごとの allocsPerItem を比べる。
+// - format=compact (JObject で構築する): 最大と最小の差が最小の Tolerance 倍以内で、
+//   かつ allocsPerItem が 1 件の JSON の値の数 × AllocsPerValue 以下なら成功
+// - 通常の形式 (arena 上に構築する): 最大の件数での allocsPerItem が ArenaAllocsPerItem 以下なら成功
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHTTPLinkActorListAllocationTest, "HTTPLink.Json.ActorListAllocation",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHTTPLinkActorListAllocationTest::RunTest(const FString& Parameters)
+{
+    using namespace HTTPLinkJsonTests;
+
+    const int32 Sizes[] = { 100, 1000, 10000 };
+    const double Tolerance = 0.1;
+    const int32 Repeat = 3;
+    // JSON の値 1 つあたりに許す確保回数
+    // 値の FJsonValue, 文字列やオブジェクト/配列の中身, フィールド名, フィールドの追加, エンコード時の文字列化でおおよそ 5 回。
+    // アクタ名の取得や FTransform の変換などの分も含めて 8 回までとする。
+    // 途中のコピーが 1 段増えるだけで値あたり 2 回以上増えるので、コピーの除去が戻ればここで失敗する
+    const double AllocsPerValue = 8.0;
+    // arena 上に構築する場合、確保は arena のブロックと出力のバッファのみで件数あたりでは 1 回に満たない。
+    // 件数によらない確保 (アクタの列挙など) が無視できる最大の件数でのみ確かめる
+    const double ArenaAllocsPerItem = 1.0;
+
+    if (!FAllocationCounter::IsAvailable()) {
+        AddWarning(TEXT("allocation counters are not available in this build. skipped."));
+        return true;
+    }
+    UWorld* World = FAutomationEditorCommonUtils::CreateNewMap();
+    if (!TestNotNull(TEXT("new map"), World)) {
+        return false;
+    }
+    auto& Module = FModuleManager::LoadModuleChecked<FHTTPLinkModule>("HTTPLink");
+
+    FHTTPLinkRequest Request;
+    Request.Path = TEXT("/actor/list");
+    FHTTPLinkRequest CompactRequest = Request;
+    CompactRequest.QueryParams.Add(TEXT("format"), TEXT("compact"));
+
+    // それぞれ返ってきた件数を返す
+    // 通常の形式は HTTP と同じく arena から直接エンコードする (in-process の Call(Request, Response) は FJsonValue に変換してしまうため)
+    auto List = [&]() {
+        TOptional<FHTTPLinkResponse> Response;
+        Module.Call(Request, [&](FHTTPLinkResponse&& R) { Response.Emplace(MoveTemp(R)); });
+        if (!Response || Response->Code != EHttpServerResponseCodes::Ok || !Response->ArenaJson) {
+            return 0;
+        }
+        TArray<uint8> Data = Response->ArenaJson->Write();
+        return Response->ArenaJson->GetRoot()->GetItems().Num();
+    };
+    // 1 件あたりの値の数は ValuesPerItem に入れる (最後に追加した StaticMeshActor のもの)
+    int32 ValuesPerItem = 0;
+    auto ListCompact = [&]() {
+        FHTTPLinkResponse Response;
+        if (!Module.Call(CompactRequest, Response) || Response.Code != EHttpServerResponseCodes::Ok || !Response.Json) {
+            return 0;
+        }
+        TArray<uint8> Data;
+        FMemoryWriter MemWriter(Data);
+        FJsonSerializer::Serialize(Response.Json, FString(), TJsonWriterFactory<UTF8CHAR>::Create(&MemWriter));
+
+        const auto& Items = Response.Json->AsObject()->GetArrayField(TEXT("items"));
+        if (!ValuesPerItem && Items.Num()) {
+            ValuesPerItem = CountJsonValues(Items.Last());
+        }
+        return Items.Num();
+    };
+
+    // ラベルの生成など初回のみの確保を除き、他スレッドの確保が混ざるので最小値をとる
+    // 事前に置かれているアクタもあるので件数はレスポンスから数える
+    auto Measure = [&](const TCHAR* What, auto&& F, int32 Size, double& PerItem) {
+        const int32 Items = F();
+        if (!TestTrue(What, Items >= Size)) {
+            return false;
+        }
+        uint64 NumAllocs = TNumericLimits<uint64>::Max();
+        for (int32 R = 0; R < Repeat; ++R) {
+            const uint64 Begin = FAllocationCounter::Now();
+            F();
+            NumAllocs = FMath::Min(NumAllocs, FAllocationCounter::Now() - Begin);
+        }
+        PerItem = (double)NumAllocs / Items;
+        AddInfo(FString::Printf(TEXT("%s, %d items: %llu allocs, %.2f allocs/item"), What, Items, NumAllocs, PerItem));
+        return true;
+    };
+
+    double MinPerItem = TNumericLimits<double>::Max();
+    double MaxPerItem = 0.0;
+    double ArenaPerItem = 0.0;
+    int32 NumActors = 0;
+    for (int32 Size : Sizes) {
+        for (; NumActors < Size; ++NumActors) {
+            World->SpawnActor<AStaticMeshActor>();
+        }
+        double PerItem;
+        if (!Measure(TEXT("/actor/list?format=compact"), ListCompact, Size, PerItem) || !Measure(TEXT("/actor/list"), List, Size, ArenaPerItem)) {
+            return false;
+        }
+        MinPerItem = FMath::Min(MinPerItem, PerItem);
+        MaxPerItem = FMath::Max(MaxPerItem, PerItem);
+    }
+
+    TestTrue(FString::Printf(TEXT("allocs/item stays within %.0f%% (min %.2f, max %.2f)"), Tolerance * 100.0, MinPerItem, MaxPerItem),
+        MaxPerItem - MinPerItem <= MinPerItem * Tolerance);
+    const double MaxAllowed = AllocsPerValue * ValuesPerItem;
+    TestTrue(FString::Printf(TEXT("allocs/item is at most %.0f (%d values x %.0f, max %.2f)"), MaxAllowed, ValuesPerItem, AllocsPerValue, MaxPerItem),
+        ValuesPerItem > 0 && MaxPerItem <= MaxAllowed);
+    TestTrue(FString::Printf(TEXT("arena allocs/item at %d items is at most %.0f (%.2f)"), NumActors, ArenaAllocsPerItem, ArenaPerItem),
+        ArenaPerItem <= ArenaAllocsPerItem);
+    return true;
+}
+#pragma endregion Allocation
+
+#endif
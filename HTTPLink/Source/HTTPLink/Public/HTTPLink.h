@@ -11,6 +11,45 @@
 #include "HttpServerRequest.h"
 #include "HttpServerResponse.h"
 #include "IHttpRouter.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+
+
+// transport に依存しないリクエスト / レスポンス
+// コマンドはこれを受け取り、HTTP サーバーとは HTTPLink.cpp 内のアダプタで繋がる。
+// FHTTPLinkModule::Call() を使えばソケットを介さず in-process でコマンドを呼べる。
+struct FHTTPLinkRequest
+{
+    FString Path;
+    TMap<FString, FString> QueryParams;
+    // 型付き引数。設定されている場合 "json" パラメータやボディより優先され、ここにない引数は QueryParams から取る
+    TSharedPtr<FJsonObject> Args;
+    // リクエストボディ。ハンドラの呼び出し中のみ有効
+    // upload=<id> が指定されている場合はアップロード済みのデータ (メモリマップされたファイルのこともある) を指す
+    TArrayView64<const uint8> Body;
+    FString ContentType;
+    // "json" パラメータかボディを解析した結果 (JSON でなければ nullptr)。最初に引数を読んだ時に設定される
+    mutable TOptional<TSharedPtr<FJsonObject>> ParsedArgs;
+};
+
+class FJsonArenaDocument;
+class FLogRing;
+
+struct FHTTPLinkResponse
+{
+    EHttpServerResponseCodes Code = EHttpServerResponseCodes::Ok;
+    FString ContentType;
+    TArray<uint8> Body;
+    // 構造化された結果。これが設定されている場合、Body へのエンコードは transport 側で行う
+    TSharedPtr<FJsonValue> Json;
+    // arena 上に構築された結果 (JsonArena.h)。Json と同様に transport 側でエンコードする
+    // in-process の Call(Request, Response) では Json に変換して返す
+    TSharedPtr<FJsonArenaDocument> ArenaJson;
+    TMap<FString, TArray<FString>> Headers;
+};
+
+using FHTTPLinkResultCallback = TFunction<void(FHTTPLinkResponse&& Response)>;
+using FHTTPLinkHandler = TFunction<bool(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result)>;
 
 
 class HTTPLINK_API FHTTPLinkModule
@@ -18,59 +57,174 @@ class HTTPLINK_API FHTTPLinkModule
     , public FTSTickerObjectBase
 {
 public:
-    class FSimpleOutputDevice : public FOutputDevice
-    {
-    using Super = FOutputDevice;
-    public:
-        FSimpleOutputDevice();
-        void Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const class FName& Category) override;
-        void Clear();
-
-        FString Log;
-    };
-
-public:
-    const int PORT = 8110;
+    // 使用するポートの範囲。Engine.ini の [HTTPLink] PortMin / PortMax で変更できる
+    // 同一マシン上の複数のエディタはこの範囲から空いているポートを 1 つずつ使う
+    int PortMin = 8110;
+    int PortMax = 8129;
+    // 実際に listen しているポート。listen していない場合は 0
+    int Port = 0;
+    // これを超えるアップロードは一時ファイルに書き出してメモリマップで参照する
+    const int64 UploadSpillThreshold = 64 * 1024 * 1024;
+    const double UploadExpireSeconds = 30.0 * 60.0;
+    // /actor/list などのエンコード済みレスポンスのキャッシュの上限
+    const int64 ResponseCacheCapacity = 64 * 1024 * 1024;
+    // この秒数更新がない編集セッションは自動的に確定する
+    const double EditSessionTimeout = 30.0;
+    // /asset/thumbnail のキャッシュの上限と、1 フレームあたりのレンダリングに使ってよい時間 (秒)
+    const int64 ThumbnailMemoryCapacity = 64 * 1024 * 1024;
+    const int64 ThumbnailDiskCapacity = 512 * 1024 * 1024;
+    const double ThumbnailRenderBudget = 0.02;
+    // /log/tail のために保持するログのスロット数 (1 スロット 240 文字)
+    const int32 LogRingCapacity = 16384;
 
     virtual void StartupModule() override;
     virtual void ShutdownModule() override;
     virtual bool Tick(float DeltaTime) override;
 
+    // in-process からのコマンド呼び出し
+    // Result はその場で呼ばれることもあれば、後のフレームで呼ばれることもある
+    bool Call(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    // その場で完了した場合のみ true を返す
+    bool Call(const FHTTPLinkRequest& Request, FHTTPLinkResponse& Response);
+
     TSharedRef<FExtender> BuildActorContextMenu(const TSharedRef<FUICommandList> CommandList, const TArray<AActor*> Actors);
     void CopyLinkAddress(const TArray<AActor*> Actors);
 
     // editor commands
-    bool OnEditorExec(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
-    bool OnEditorScreenshot(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
+    bool OnEditorExec(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnEditorScreenshot(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
     void OnScreenshotProcessed();
+    bool OnLogTail(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+
+    // viewport commands
+    bool OnViewportCamera(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnViewportCameraSet(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
 
     // actor commands
-    bool OnActorList(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
-    bool OnActorSelect(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
-    bool OnActorFocus(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
-    bool OnActorCreate(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
-    bool OnActorDelete(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
-    bool OnActorMerge(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
-    bool OnActorTransform(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
+    bool OnActorList(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorTree(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorSelect(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorFocus(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorCreate(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorDelete(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorMerge(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorTransform(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorTransforms(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorQueryBox(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorQuerySphere(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorQueryRay(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorQueryNearest(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorPropertyGet(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnActorPropertySet(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+
+    // edit session commands
+    bool OnEditBegin(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnEditEnd(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnEditStatus(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
 
     // level commands
-    bool OnLevelNew(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
-    bool OnLevelLoad(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
-    bool OnLevelSave(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
+    bool OnLevelNew(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnLevelLoad(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnLevelSave(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
 
     // asset commands
-    bool OnAssetList(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
-    bool OnAssetImport(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
+    bool OnAssetList(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnAssetImport(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnAssetDependencies(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnAssetReferencers(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnAssetThumbnail(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+
+    // job commands
+    bool OnJobStatus(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+
+    // instance commands
+    bool OnInstances(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+
+    // cache commands
+    bool OnCacheStats(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnCacheClear(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+
+    // upload commands
+    bool OnUpload(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnUploadBegin(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnUploadAppend(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnUploadFinish(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+    bool OnUploadDelete(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
 
     // test commands
-    bool OnTest(const FHttpServerRequest& Request, const FHttpResultCallback& Result);
+    bool OnTest(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
 
 private:
-    FPlatformProcess::FSemaphore* GlobalLock = nullptr;
+    void UpdateInstanceRegistry();
+    void RemoveInstanceRegistry();
+
+    struct FLogTail;
+    bool ServeLogTail(FLogTail& Tail);
+    void TickLogTails();
+
+    struct FCameraChannel;
+    FCameraChannel& GetCameraChannel();
+    void TickCamera();
+
+    struct FResponseCache;
+    FResponseCache& GetResponseCache();
+    bool CallCached(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result);
+
+    struct FEditSession;
+    bool ResolveEditSession(const FHTTPLinkRequest& Request, FEditSession*& OutSession);
+    TSharedPtr<FJsonObject> EndEditSession(bool Cancel);
+    void TickEditSession();
+
+    struct FJob;
+    TSharedRef<FJob> StartJob(const FString& Type, TFunction<bool(FJob& Job)>&& Step);
+    TSharedRef<FJob> StartLevelJob(const FString& Type, const FString& PreloadPath, TFunction<bool()>&& Switch);
+    void TickJobs();
+
+    struct FUpload;
+    FUpload* FindUpload(const FString& Id);
+    FUpload& NewUpload();
+    bool ResolveUploadBody(const FHTTPLinkRequest& Request, TArrayView64<const uint8>& Dst);
+
+    struct FActorSpatialIndex;
+    FActorSpatialIndex& GetSpatialIndex();
+
+    struct FPropertyPathCache;
+    FPropertyPathCache& GetPropertyPathCache();
+
+    struct FQueryFilters;
+    FQueryFilters& GetQueryFilters();
+
+    struct FAssetGraph;
+    FAssetGraph& GetAssetGraph();
+    bool ServeAssetGraphQuery(const FHTTPLinkRequest& Request, const FHTTPLinkResultCallback& Result, bool Forward);
+
+    struct FThumbnailCache;
+    FThumbnailCache& GetThumbnailCache();
+    void TickThumbnails();
+
+    TMap<FString, FHTTPLinkHandler> Handlers;
+    TMap<int32, TSharedPtr<FJob>> Jobs;
+    int32 LastJobId = 0;
+    TMap<FString, TSharedPtr<FUpload>> Uploads;
+    TSharedPtr<FEditSession> EditSession;
+    int32 LastEditSessionId = 0;
+
+    FPlatformProcess::FSemaphore* PortLock = nullptr;
     TSharedPtr<IHttpRouter> Router;
     TArray<FHttpRouteHandle> HRoutes;
-    FSimpleOutputDevice Outputs;
+    TSharedPtr<FLogRing> LogRing;
+    TArray<TSharedPtr<FLogTail>> LogTails;
 
     FDelegateHandle HScreenshot;
+    FDelegateHandle HMapChange;
+    FDelegateHandle HMapLoad;
     bool bScreenshotInProgress = false;
+
+    TSharedPtr<FActorSpatialIndex> SpatialIndex;
+    TSharedPtr<FPropertyPathCache> PropertyPaths;
+    TSharedPtr<FQueryFilters> QueryFilters;
+    TSharedPtr<FResponseCache> ResponseCache;
+    TSharedPtr<FAssetGraph> AssetGraph;
+    TSharedPtr<FThumbnailCache> ThumbnailCache;
+    TSharedPtr<FCameraChannel> CameraChannel;
 };